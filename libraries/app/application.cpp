@@ -29,6 +29,7 @@
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 #include <graphene/chain/protocol/types.hpp>
+#include <graphene/chain/signature_cache.hpp>
 
 #include <graphene/egenesis/egenesis.hpp>
 
@@ -46,6 +47,7 @@
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/network/resolve.hpp>
 #include <fc/crypto/base64.hpp>
+#include <fc/thread/thread.hpp>
 
 #include <boost/filesystem/path.hpp>
 #include <boost/signals2.hpp>
@@ -71,6 +73,7 @@ using chain::block_header;
 using chain::signed_block_header;
 using chain::signed_block;
 using chain::block_id_type;
+using chain::block_database_options;
 
 using std::vector;
 
@@ -395,6 +398,46 @@ void application_impl::startup()
    if( _options->count("replay-blockchain") )
       _chain_db->wipe( _data_dir / "blockchain", false );
 
+   block_database_options block_db_options;
+   if( _options->count("block-log-mmap") )
+      block_db_options.memory_mapped = _options->at("block-log-mmap").as<bool>();
+   if( _options->count("block-log-segmented") )
+      block_db_options.segmented = _options->at("block-log-segmented").as<bool>();
+   if( _options->count("block-log-blocks-per-segment") )
+      block_db_options.blocks_per_segment = _options->at("block-log-blocks-per-segment").as<uint32_t>();
+   if( _options->count("block-log-compress") )
+      block_db_options.compress = _options->at("block-log-compress").as<bool>();
+   if( _options->count("block-log-retain") )
+   {
+      block_db_options.retain_blocks = _options->at("block-log-retain").as<uint32_t>();
+      block_db_options.segmented = block_db_options.retain_blocks > 0 || block_db_options.segmented;
+   }
+   _chain_db->set_block_database_options( block_db_options );
+   if( _options->count("replay-prefetch-blocks") )
+      _chain_db->set_reindex_prefetch_blocks( _options->at("replay-prefetch-blocks").as<uint32_t>() );
+   if( _options->count("replay-verify-signatures") )
+      _chain_db->set_replay_verify_signatures( _options->at("replay-verify-signatures").as<bool>() );
+   if( _options->count("block-profiler") )
+      _chain_db->get_block_profiler().set_enabled( _options->at("block-profiler").as<bool>() );
+   if( _options->count("block-profiler-window") )
+      _chain_db->get_block_profiler().set_window_blocks( _options->at("block-profiler-window").as<uint32_t>() );
+   if( _options->count("replay-profile-dump") )
+      _chain_db->set_replay_profile_dump( _options->at("replay-profile-dump").as<bool>() );
+   if( _options->count("state-hashes") )
+      _chain_db->set_state_hash_tracking( _options->at("state-hashes").as<bool>() );
+   if( _options->count("maintenance-threads") )
+      _chain_db->set_maintenance_threads( _options->at("maintenance-threads").as<uint32_t>() );
+   if( _options->count("state-journal") )
+      _chain_db->set_journal_enabled( _options->at("state-journal").as<bool>() );
+   if( _options->count("journal-checkpoint-blocks") )
+      _chain_db->set_journal_checkpoint_blocks( _options->at("journal-checkpoint-blocks").as<uint32_t>() );
+   if( _options->count("signature-cache-size") )
+      signature_cache::instance().set_capacity( _options->at("signature-cache-size").as<uint32_t>() );
+
+   if( _options->count("snapshot") )
+      _chain_db->import_snapshot( _options->at("snapshot").as<boost::filesystem::path>(), _data_dir / "blockchain",
+                                  GRAPHENE_CURRENT_DB_VERSION );
+
    try
    {
       _chain_db->open( _data_dir / "blockchain", initial_state, GRAPHENE_CURRENT_DB_VERSION );
@@ -405,6 +448,13 @@ void application_impl::startup()
       throw;
    }
 
+   if( _options->count("create-snapshot") )
+   {
+      _chain_db->create_snapshot( _options->at("create-snapshot").as<boost::filesystem::path>() );
+      _chain_db->close();
+      std::exit(EXIT_SUCCESS);
+   }
+
    if( _options->count("force-validate") )
    {
       ilog( "All transaction signatures will be validated" );
@@ -414,6 +464,9 @@ void application_impl::startup()
    if( _active_plugins.find( "market_history" ) != _active_plugins.end() )
       _app_options.has_market_history_plugin = true;
 
+   if( _options->count("api-read-thread") && _options->at("api-read-thread").as<bool>() )
+      _app_options.api_read_thread = std::make_shared<fc::thread>( "api_read" );
+
    if( _options->count("api-access") ) {
 
       if(fc::exists(_options->at("api-access").as<boost::filesystem::path>()))
@@ -577,6 +630,9 @@ void application_impl::handle_message(const message& message_to_process)
 bool application_impl::is_included_block(const block_id_type& block_id)
 {
   uint32_t block_num = block_header::num_from_id(block_id);
+  // blocks pruned from the block log can neither be looked up nor served
+  if( block_num < _chain_db->first_stored_block_num() )
+    return false;
   block_id_type block_id_in_preferred_chain = _chain_db->get_block_id_for_num(block_num);
   return block_id == block_id_in_preferred_chain;
 }
@@ -626,6 +682,11 @@ std::vector<item_hash_t> application_impl::get_block_ids(const std::vector<item_
        FC_THROW_EXCEPTION( graphene::net::peer_is_on_an_unreachable_fork,
                            "Unable to provide a list of blocks starting at any of the blocks in peer's synopsis" );
    }
+   const uint32_t first_stored_block_num = _chain_db->first_stored_block_num();
+   if( block_header::num_from_id(last_known_block_id) + 1 < first_stored_block_num )
+     FC_THROW_EXCEPTION( graphene::net::peer_is_on_an_unreachable_fork,
+                         "Unable to provide the blocks after #${n}, blocks are kept from #${first}",
+                         ("n", block_header::num_from_id(last_known_block_id))("first", first_stored_block_num) );
    for( uint32_t num = block_header::num_from_id(last_known_block_id);
         num <= _chain_db->head_block_num() && result.size() < limit;
         ++num )
@@ -646,6 +707,17 @@ message application_impl::get_item(const item_id& id)
   // ilog("Request for item ${id}", ("id", id));
    if( id.item_type == graphene::net::block_message_type )
    {
+      // key_not_found makes the node answer with item_not_available
+      const uint32_t block_num = block_header::num_from_id(id.item_hash);
+      if( block_num < _chain_db->first_stored_block_num() )
+         FC_THROW_EXCEPTION( fc::key_not_found_exception, "Block #${n} was pruned, blocks are kept from #${first}",
+                             ("n", block_num)("first", _chain_db->first_stored_block_num()) );
+
+      // Serve blocks from the block log as stored, the peer gets the very same bytes
+      auto raw_block = _chain_db->fetch_raw_block_by_id(id.item_hash);
+      if( raw_block )
+         return block_message::from_packed_block(std::move(*raw_block), id.item_hash);
+
       auto opt_block = _chain_db->fetch_block_by_id(id.item_hash);
       if( !opt_block )
          elog("Couldn't find block ${id} -- corresponding ID in our chain is ${id2}",
@@ -735,6 +807,10 @@ std::vector<item_hash_t> application_impl::get_blockchain_synopsis(const item_ha
       // the node is asking for a summary of the block chain up to a specified
       // block, which may or may not be on a fork
       // for now, assume it's not on a fork
+      if (block_header::num_from_id(reference_point) < _chain_db->first_stored_block_num())
+        FC_THROW_EXCEPTION(graphene::net::block_older_than_undo_history,
+                           "Reference point #${n} was pruned from the block log",
+                           ("n", block_header::num_from_id(reference_point)));
       if (is_included_block(reference_point))
       {
         // reference_point is a block we know about and is on the main chain
@@ -814,6 +890,8 @@ std::vector<item_hash_t> application_impl::get_blockchain_synopsis(const item_ha
 
     if( low_block_num == 0)
        low_block_num = 1;
+    // the synopsis can't name blocks that were pruned from the block log
+    low_block_num = std::max(low_block_num, _chain_db->first_stored_block_num());
 
     // at this point:
     // low_block_num is the block before the first block we can undo,
@@ -941,6 +1019,38 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("api-access", bpo::value<boost::filesystem::path>(), "JSON file specifying API permissions")
          ("plugins", bpo::value<string>(), "Space-separated list of plugins to activate")
          ("io-threads", bpo::value<uint16_t>()->implicit_value(0), "Number of IO threads, default to 0 for auto-configuration")
+         ("block-log-mmap", bpo::value<bool>()->implicit_value(true),
+          "Read stored blocks through memory maps so API and p2p requests can fetch blocks concurrently")
+         ("block-log-segmented", bpo::value<bool>()->implicit_value(true),
+          "Store blocks in fixed-size segments that are compacted in the background, an existing block log is converted on start")
+         ("block-log-blocks-per-segment", bpo::value<uint32_t>()->default_value(100000),
+          "Block numbers per segment of the segmented block log, must not change once the log exists")
+         ("block-log-compress", bpo::value<bool>()->default_value(true),
+          "zlib-compress blocks in the segmented block log")
+         ("block-log-retain", bpo::value<uint32_t>(),
+          "Keep only the most recent N blocks, and at least the last irreversible one, implies block-log-segmented")
+         ("replay-prefetch-blocks", bpo::value<uint32_t>()->default_value(1000),
+          "Number of blocks a replay reads and hashes ahead on a separate thread, 0 to read them on the applying thread")
+         ("replay-verify-signatures", bpo::value<bool>()->implicit_value(true),
+          "Check the witness and transaction signatures of every replayed block and stop at the first one that fails, the keys are recovered on all cores ahead of the replay")
+         ("block-profiler", bpo::value<bool>()->implicit_value(true),
+          "Time the phases of applying every block and the evaluators of its operations, see get_block_profile_stats")
+         ("block-profiler-window", bpo::value<uint32_t>()->default_value(block_profiler::default_window_blocks),
+          "Number of blocks per window of the block profiler's histograms, they cover the last one to two windows")
+         ("replay-profile-dump", bpo::value<bool>()->implicit_value(true),
+          "Log the phase and operation timings of every block applied while replaying, implies block-profiler")
+         ("state-hashes", bpo::value<bool>()->implicit_value(true),
+          "Keep the hash of every index current and record the state hashes of recent blocks for get_state_hashes, at the cost of hashing every changed object twice")
+         ("maintenance-threads", bpo::value<uint32_t>()->default_value(1),
+          "Number of threads the vote tally of maintenance blocks is split over, 1 to tally on the applying thread, 0 for one per core")
+         ("state-journal", bpo::value<bool>()->default_value(false),
+          "Journal the objects changed by every block, so after an unclean shutdown the node resumes from its last irreversible block instead of replaying from the last clean one")
+         ("journal-checkpoint-blocks", bpo::value<uint32_t>()->default_value(10000),
+          "With state-journal, write the object database and start the journal over every this many irreversible blocks, 0 never to")
+         ("signature-cache-size", bpo::value<uint32_t>()->default_value(uint32_t(signature_cache::default_capacity)),
+          "Number of public keys recovered from transaction signatures to keep, so no signature is recovered twice, 0 to disable")
+         ("api-read-thread", bpo::value<bool>()->default_value(true),
+          "Run heavy database API queries on a separate thread against a snapshot of the state, so they do not hold up block application")
          // TODO uncomment this when GUI is ready
          //("enable-subscribe-to-all", bpo::value<bool>()->implicit_value(false),
          // "Whether allow API clients to subscribe to universal object creation and removal events")
@@ -953,6 +1063,10 @@ void application::set_program_options(boost::program_options::options_descriptio
           "invalid file is found, it will be replaced with an example Genesis State.")
          ("replay-blockchain", "Rebuild object graph by replaying all blocks")
          ("resync-blockchain", "Delete all blocks and re-sync with network from scratch")
+         ("snapshot", bpo::value<boost::filesystem::path>(),
+          "Start from the blockchain state in a snapshot file if there is no state yet, add resync-blockchain to replace it")
+         ("create-snapshot", bpo::value<boost::filesystem::path>(),
+          "Write a snapshot of the state at the last irreversible block to this file once the database is open, then exit")
          ("force-validate", "Force validation of all transactions")
          ("genesis-timestamp", bpo::value<uint32_t>(),
           "Replace timestamp from genesis.json with current time plus this many seconds (experts only!)")
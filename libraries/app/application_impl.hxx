@@ -36,6 +36,8 @@ class application_impl : public net::node_delegate
 
       ~application_impl()
       {
+         if( _app_options.api_read_thread )
+            _app_options.api_read_thread->quit();
       }
 
       void set_dbg_init_key( graphene::chain::genesis_state_type& genesis, const std::string& init_key );
@@ -30,10 +30,13 @@
 #include <graphene/chain/withdrawal_limit_object.hpp>
 #include <graphene/chain/issued_asset_record_object.hpp>
 
+#include <graphene/db/read_view.hpp>
+
 #include <fc/bloom_filter.hpp>
 #include <fc/smart_ref_impl.hpp>
 
 #include <fc/crypto/hex.hpp>
+#include <fc/thread/thread.hpp>
 #include <fc/uint128.hpp>
 
 #include <boost/range/iterator_range.hpp>
@@ -75,6 +78,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       map<uint32_t, optional<block_header>> get_block_header_batch(const vector<uint32_t> block_nums)const;
       optional<signed_block> get_block(uint32_t block_num)const;
       vector<signed_block_with_num> get_blocks(uint32_t block_num, uint32_t count) const;
+      vector<packed_block_with_num> get_blocks_raw(uint32_t block_num, uint32_t count) const;
       vector<signed_block_with_virtual_operations_and_num> get_blocks_with_virtual_operations(uint32_t start_block_num,
                                                                                               uint32_t count,
                                                                                               std::vector<uint16_t>& virtual_operation_ids) const;
@@ -87,6 +91,10 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       chain_id_type get_chain_id()const;
       dynamic_global_property_object get_dynamic_global_properties()const;
       optional<total_cycles_res> get_total_cycles() const;
+      optional<state_hashes> get_state_hashes( uint32_t block_num )const;
+      std::map<std::pair<uint32_t,uint32_t>, node_pool_stats> get_index_pool_stats()const;
+      signature_cache_stats get_signature_cache_stats()const;
+      block_profile_stats get_block_profile_stats()const;
 
       // Keys
       vector<vector<account_id_type>> get_key_references( vector<public_key_type> key )const;
@@ -350,6 +358,20 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
          return result;
       }
 
+      /**
+       * Calls reader with a read_view of the current state. Applications that run an API read thread run it
+       * there, so blocks keep being applied while it works.
+       */
+      template<typename Reader>
+      auto read_from_view( Reader&& reader )const -> decltype( reader( std::declval<const read_view&>() ) )
+      {
+         auto view = _db.open_read_view();
+         fc::thread* thread = _app_options ? _app_options->api_read_thread.get() : nullptr;
+         if( thread == nullptr || thread == &fc::thread::current() )
+            return reader( *view );
+         return thread->async( [&reader, view]() { return reader( *view ); }, "database_api_read" ).wait();
+      }
+
       template<typename T>
       void enqueue_if_subscribed_to_market(const object* obj, market_queue_type& queue, bool full_object=true)
       {
@@ -588,6 +610,16 @@ vector<signed_block_with_num> database_api_impl::get_blocks(uint32_t start_block
     return _dal.get_blocks(start_block_num, count);
 }
 
+vector<packed_block_with_num> database_api::get_blocks_raw(uint32_t start_block_num, uint32_t count) const
+{
+    return my->get_blocks_raw(start_block_num, count);
+}
+
+vector<packed_block_with_num> database_api_impl::get_blocks_raw(uint32_t start_block_num, uint32_t count) const
+{
+    return _dal.get_blocks_raw(start_block_num, count);
+}
+
 vector<signed_block_with_virtual_operations_and_num> database_api::get_blocks_with_virtual_operations(uint32_t start_block_num,
                                                                                uint32_t count,
                                                                                std::vector<uint16_t> virtual_operation_ids) const
@@ -680,6 +712,46 @@ dynamic_global_property_object database_api_impl::get_dynamic_global_properties(
    return _db.get(dynamic_global_property_id_type());
 }
 
+optional<state_hashes> database_api::get_state_hashes( uint32_t block_num )const
+{
+   return my->get_state_hashes( block_num );
+}
+
+optional<state_hashes> database_api_impl::get_state_hashes( uint32_t block_num )const
+{
+   return _db.get_state_hashes( block_num );
+}
+
+std::map<std::pair<uint32_t,uint32_t>, node_pool_stats> database_api::get_index_pool_stats()const
+{
+   return my->get_index_pool_stats();
+}
+
+std::map<std::pair<uint32_t,uint32_t>, node_pool_stats> database_api_impl::get_index_pool_stats()const
+{
+   return _db.get_pool_stats();
+}
+
+signature_cache_stats database_api::get_signature_cache_stats()const
+{
+   return my->get_signature_cache_stats();
+}
+
+signature_cache_stats database_api_impl::get_signature_cache_stats()const
+{
+   return signature_cache::instance().get_stats();
+}
+
+block_profile_stats database_api::get_block_profile_stats()const
+{
+   return my->get_block_profile_stats();
+}
+
+block_profile_stats database_api_impl::get_block_profile_stats()const
+{
+   return _db.get_block_profiler().get_stats();
+}
+
 optional<total_cycles_res> database_api::get_total_cycles() const {
     return my->get_total_cycles();
 }
@@ -1319,92 +1391,88 @@ limit_orders_grouped_by_price database_api::get_limit_orders_grouped_by_price(as
 
 limit_orders_grouped_by_price database_api_impl::get_limit_orders_grouped_by_price(asset_id_type base, asset_id_type quote, uint32_t limit)const
 {
-   const auto& limit_order_idx = _db.get_index_type<limit_order_index>();
-   const auto& limit_price_idx = limit_order_idx.indices().get<by_price>();
+   return read_from_view( [&]( const read_view& view ) {
+      limit_orders_grouped_by_price result;
+      bool swap_buy_sell = false;
+      if(base < quote)
+      {
+         std::swap(base,quote);
+         swap_buy_sell = true;
+      }
 
-   limit_orders_grouped_by_price result;
-   bool swap_buy_sell = false;
-   if(base < quote)
-   {
-      std::swap(base,quote);
-      swap_buy_sell = true;
-   }
+      auto func = [&view, limit](asset_id_type& a, asset_id_type& b, std::vector<aggregated_limit_orders_with_same_price>& ret, bool ascending){
+         std::map<share_type, aggregated_limit_orders_with_same_price> helper_map;
 
-   auto func = [this, &limit_price_idx, limit](asset_id_type& a, asset_id_type& b, std::vector<aggregated_limit_orders_with_same_price>& ret, bool ascending){
-      std::map<share_type, aggregated_limit_orders_with_same_price> helper_map;
+         const auto limit_orders = view.get_range<limit_order_index, by_price>(price::max(a,b), price::min(a,b));
 
-      auto limit_itr = limit_price_idx.lower_bound(price::max(a,b));
-      auto limit_end = limit_price_idx.upper_bound(price::min(a,b));
+         const auto asset_a = view.get(a);
+         const auto asset_b = view.get(b);
+         double coef = asset::scaled_precision(asset_a.precision).value * 1.0 / asset::scaled_precision(asset_b.precision).value;
 
-      auto& asset_a = _db.get(a);
-      auto& asset_b = _db.get(b);
-      double coef = asset::scaled_precision(asset_a.precision).value * 1.0 / asset::scaled_precision(asset_b.precision).value;
+         for(auto limit_itr = limit_orders.begin(); limit_itr != limit_orders.end(); ++limit_itr)
+         {
+            double price = ascending ? 1 / limit_itr->sell_price.to_real() : limit_itr->sell_price.to_real();
+            // adjust price precision and value accordingly so we can forme key
+            auto p = round((ascending ? price * coef : price / coef) * ORDER_BOOK_QUERY_PRECISION);
+            share_type price_key = static_cast<share_type>(p);
 
-      while(limit_itr != limit_end)
-      {
-         double price = ascending ? 1 / limit_itr->sell_price.to_real() : limit_itr->sell_price.to_real();
-         // adjust price precision and value accordingly so we can forme key
-         auto p = round((ascending ? price * coef : price / coef) * ORDER_BOOK_QUERY_PRECISION);
-         share_type price_key = static_cast<share_type>(p);
+            auto helper_itr = helper_map.find(price_key);
 
-         auto helper_itr = helper_map.find(price_key);
+            // if we are adding limit order with new price
+            if(helper_itr == helper_map.end())
+            {
+               aggregated_limit_orders_with_same_price alo;
+               alo.price = price_key;
+               alo.base_volume = limit_itr->for_sale.value;
+               alo.quote_volume = round(ascending ? limit_itr->for_sale.value * price : limit_itr->for_sale.value / price);
+               alo.count = 1;
 
-         // if we are adding limit order with new price
-         if(helper_itr == helper_map.end())
-         {
-            aggregated_limit_orders_with_same_price alo;
-            alo.price = price_key;
-            alo.base_volume = limit_itr->for_sale.value;
-            alo.quote_volume = round(ascending ? limit_itr->for_sale.value * price : limit_itr->for_sale.value / price);
-            alo.count = 1;
+               helper_map[price_key] = alo;
+            }
+            else
+            {
+               helper_itr->second.base_volume += limit_itr->for_sale.value;;
+               helper_itr->second.quote_volume += round(ascending ? limit_itr->for_sale.value * price : limit_itr->for_sale.value / price);
+               helper_itr->second.count++;
+            }
+         }
 
-            helper_map[price_key] = alo;
+         // re-pack result in vector (from map) in desired order
+         uint32_t count = 0;
+         if(ascending)
+         {
+            auto helper_itr = helper_map.begin();
+            while(helper_itr != helper_map.end() && count < limit)
+            {
+               ret.push_back(helper_itr->second);
+               helper_itr++;
+               count++;
+            }
          }
          else
          {
-            helper_itr->second.base_volume += limit_itr->for_sale.value;;
-            helper_itr->second.quote_volume += round(ascending ? limit_itr->for_sale.value * price : limit_itr->for_sale.value / price);
-            helper_itr->second.count++;
+            auto helper_itr = helper_map.rbegin();
+            while(helper_itr != helper_map.rend() && count < limit)
+            {
+               ret.push_back(helper_itr->second);
+               helper_itr++;
+               count++;
+            }
          }
+      };
 
-         ++limit_itr;
-      }
-
-      // re-pack result in vector (from map) in desired order
-      uint32_t count = 0;
-      if(ascending)
+      if(swap_buy_sell)
       {
-         auto helper_itr = helper_map.begin();
-         while(helper_itr != helper_map.end() && count < limit)
-         {
-            ret.push_back(helper_itr->second);
-            helper_itr++;
-            count++;
-         }
-      }
-      else
+         func(base, quote, result.buy, false);
+         func(quote, base, result.sell, true);
+      } else
       {
-         auto helper_itr = helper_map.rbegin();
-         while(helper_itr != helper_map.rend() && count < limit)
-         {
-            ret.push_back(helper_itr->second);
-            helper_itr++;
-            count++;
-         }
+         func(base, quote, result.sell, true);
+         func(quote, base, result.buy, false);
       }
-   };
-
-   if(swap_buy_sell)
-   {
-      func(base, quote, result.buy, false);
-      func(quote, base, result.sell, true);
-   } else
-   {
-      func(base, quote, result.sell, true);
-      func(quote, base, result.buy, false);
-   }
 
-   return std::move(result);
+      return result;
+   });
 }
 
 limit_orders_collection_grouped_by_price database_api::get_limit_orders_collection_grouped_by_price(asset_id_type a, asset_id_type b, uint32_t limit_group, uint32_t limit_per_group) const
@@ -2839,40 +2907,51 @@ vector<dasc_holder> database_api::get_top_dasc_holders() const
 
 vector<dasc_holder> database_api_impl::get_top_dasc_holders() const
 {
-    static const uint32_t max_holders = 100;
-    vector<dasc_holder> tmp;
-    const auto& dasc_id = _db.get_dascoin_asset_id();
-    const auto& idx = _db.get_index_type<account_index>().indices().get<by_id>();
-    for ( auto it = idx.cbegin(); it != idx.cend(); ++it )
-    {
-        const auto& account = *it;
-        dasc_holder holder;
-        holder.holder = account.id;
-        if (account.kind == account_kind::wallet)
-        {
-            holder.vaults = account.vault.size();
-            const auto& balance_obj = _db.get_balance_object(account.id, dasc_id);
-            holder.amount = balance_obj.balance + balance_obj.reserved;
-            std::for_each(account.vault.begin(), account.vault.end(), [this, &holder, &dasc_id](const account_id_type& vault_id) {
-                const auto& balance_obj = _db.get_balance_object(vault_id, dasc_id);
-                holder.amount += balance_obj.balance;
-            });
-            tmp.emplace_back(holder);
-        }
-        else if (account.kind == account_kind::custodian || (account.kind == account_kind::vault && account.parents.empty()))
+    return read_from_view( [this]( const read_view& view ) {
+        static const uint32_t max_holders = 100;
+        const auto dasc_id = view.get( asset_id_type(DASCOIN_DASCOIN_INDEX) ).get_id();
+        std::map<account_id_type, account_balance_object> balances;
+        for ( auto& balance_obj : view.get_range<account_balance_index, by_asset_balance>( dasc_id, dasc_id ) )
+            balances.emplace( balance_obj.owner, std::move(balance_obj) );
+        const auto get_balance_object = [&balances](account_id_type owner) -> const account_balance_object& {
+            auto itr = balances.find( owner );
+            FC_ASSERT( itr != balances.end(), "Account ${a} has no balance object for DASC", ("a", owner) );
+            return itr->second;
+        };
+
+        auto accounts = view.get_all<account_object>();
+        std::sort( accounts.begin(), accounts.end(), [](const account_object& a, const account_object& b) {
+            return a.id < b.id;
+        });
+        vector<dasc_holder> tmp;
+        for ( const auto& account : accounts )
         {
-            holder.vaults = 0;
-            const auto& balance_obj = _db.get_balance_object(account.id, dasc_id);
-            holder.amount = balance_obj.balance;
-            tmp.emplace_back(holder);
+            dasc_holder holder;
+            holder.holder = account.id;
+            if (account.kind == account_kind::wallet)
+            {
+                holder.vaults = account.vault.size();
+                const auto& balance_obj = get_balance_object(account.id);
+                holder.amount = balance_obj.balance + balance_obj.reserved;
+                std::for_each(account.vault.begin(), account.vault.end(), [&holder, &get_balance_object](const account_id_type& vault_id) {
+                    holder.amount += get_balance_object(vault_id).balance;
+                });
+                tmp.emplace_back(holder);
+            }
+            else if (account.kind == account_kind::custodian || (account.kind == account_kind::vault && account.parents.empty()))
+            {
+                holder.vaults = 0;
+                holder.amount = get_balance_object(account.id).balance;
+                tmp.emplace_back(holder);
+            }
         }
-    }
 
-    std::partial_sort(tmp.begin(), tmp.begin() + max_holders, tmp.end(), [](dasc_holder& a, dasc_holder& b) {
-        return a.amount > b.amount;
+        const size_t num_holders = std::min<size_t>( max_holders, tmp.size() );
+        std::partial_sort(tmp.begin(), tmp.begin() + num_holders, tmp.end(), [](const dasc_holder& a, const dasc_holder& b) {
+            return a.amount > b.amount;
+        });
+        return vector<dasc_holder>(tmp.begin(), tmp.begin() + num_holders);
     });
-    vector<dasc_holder> ret(tmp.begin(), tmp.begin() + max_holders);
-    return ret;
 }
 
 optional<withdrawal_limit> database_api::get_withdrawal_limit(account_id_type account, asset_id_type asset_id) const
@@ -27,6 +27,8 @@
 #include <graphene/net/node.hpp>
 #include <graphene/chain/database.hpp>
 
+#include <fc/thread/thread.hpp>
+
 #include <boost/program_options.hpp>
 
 namespace graphene { namespace app {
@@ -41,6 +43,8 @@ namespace graphene { namespace app {
          // TODO change default to false when GUI is ready
          bool enable_subscribe_to_all = true;
          bool has_market_history_plugin = false;
+         /** thread the database API runs heavy reads on against a read_view, null to run them inline */
+         std::shared_ptr<fc::thread> api_read_thread;
    };
 
    class application
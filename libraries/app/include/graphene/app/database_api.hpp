@@ -49,6 +49,8 @@
 #include <graphene/chain/witness_object.hpp>
 #include <graphene/chain/daspay_object.hpp>
 #include <graphene/chain/das33_object.hpp>
+#include <graphene/chain/signature_cache.hpp>
+#include <graphene/chain/block_profiler.hpp>
 
 #include <graphene/market_history/market_history_plugin.hpp>
 
@@ -268,6 +270,16 @@ class database_api
        */
       vector<signed_block_with_num> get_blocks(uint32_t start_block_num, uint32_t count) const;
 
+      /**
+       * @brief Same as @ref get_blocks, but each block is returned packed exactly as stored on disk.
+       * The node forwards the stored bytes without unpacking them, which makes this the cheapest way
+       * to fetch historical blocks in bulk.
+       * @param start_block_num Height of the starting block.
+       * @param count Number of blocks to return.
+       * @return Array of enumerated packed blocks
+       */
+      vector<packed_block_with_num> get_blocks_raw(uint32_t start_block_num, uint32_t count) const;
+
       /**
        * @brief Return an array of full, signed blocks that contains virtual operations starting from a specified height.
        * @param start_block_num Height of the starting block.
@@ -324,6 +336,35 @@ class database_api
        */
       optional<total_cycles_res> get_total_cycles() const;
 
+      /**
+       * @brief Get the hashes of the object state after a block
+       * @param block_num The head block or one of the last 1000 blocks this node pushed since it started
+       * @return The state hash and the hash of every index, or null if the node does not know them for block_num
+       *
+       * Two nodes compare their state by calling this with the same block_num. If the state hashes differ, the
+       * indices whose hash or next_id differ are where the nodes diverged.
+       */
+      optional<state_hashes> get_state_hashes( uint32_t block_num )const;
+
+      /**
+       * @brief Get the memory usage of the indices whose objects are allocated from node pools
+       * @return The pool usage keyed by the space and type of the index
+       */
+      std::map<std::pair<uint32_t,uint32_t>, node_pool_stats> get_index_pool_stats()const;
+
+      /**
+       * @brief Get the hit and miss counts of the cache of keys recovered from transaction signatures
+       * @return Hits, misses, cached keys and capacity, counted since the node started
+       */
+      signature_cache_stats get_signature_cache_stats()const;
+
+      /**
+       * @brief Get the timings of the phases of applying blocks and of the evaluators of their operations
+       * @return Histograms over the most recent one to two windows of blocks, empty unless the node runs with
+       * block-profiler
+       */
+      block_profile_stats get_block_profile_stats()const;
+
       //////////
       // Keys //
       //////////
@@ -1074,6 +1115,7 @@ FC_API( graphene::app::database_api,
    (get_block_header)
    (get_block)
    (get_blocks)
+   (get_blocks_raw)
    (get_blocks_with_virtual_operations)
    (get_transaction)
    (get_recent_transaction_by_id)
@@ -1085,6 +1127,10 @@ FC_API( graphene::app::database_api,
    (get_chain_id)
    (get_dynamic_global_properties)
    (get_total_cycles)
+   (get_state_hashes)
+   (get_index_pool_stats)
+   (get_signature_cache_stats)
+   (get_block_profile_stats)
 
    // Keys
    (get_key_references)
@@ -43,6 +43,32 @@ vector<signed_block_with_num> database_access_layer::get_blocks(uint32_t start_b
     return result;
 }
 
+vector<packed_block_with_num> database_access_layer::get_blocks_raw(uint32_t start_block_num, uint32_t count) const
+{
+    FC_ASSERT(count > 0, "Must fetch at least one block");
+    FC_ASSERT(count <= 100, "Too many blocks to fetch, limit is 100");
+    auto head_block_num = _db.head_block_num();
+    FC_ASSERT(start_block_num <= head_block_num,
+              "Starting block ${start_n} is higher than current block height ${head_n}",
+              ("start_n", start_block_num)
+              ("head_n", head_block_num));
+
+    vector<packed_block_with_num> result;
+    result.reserve(count);
+    auto end = start_block_num + count;
+    if (end > head_block_num)
+        end = head_block_num;
+    for (auto i = start_block_num; i < end; ++i) {
+        auto packed_block = _db.fetch_raw_block_by_number(i);
+        FC_ASSERT(packed_block.valid(),
+                  "Block number ${num} could not be retreived",
+                  ("num", i)
+                 );
+        result.emplace_back(i, _db.get_block_id_for_num(i), std::move(*packed_block));
+    }
+    return result;
+}
+
 vector<signed_block_with_virtual_operations_and_num> database_access_layer::get_blocks_with_virtual_operations(uint32_t start_block_num,
                                                                                           uint32_t count,
                                                                                           std::vector<uint16_t>& virtual_operation_ids) const
@@ -258,7 +284,7 @@ acc_id_queue_subs_w_pos_res database_access_layer::get_queue_submissions_with_po
 
     const auto& range = account_idx.equal_range(account_id);
     for (auto it = range.first; it != range.second; ++it) {
-        uint32_t pos = distance(time_idx.begin(), queue_multi_idx.project<by_time>(it));
+        uint32_t pos = time_idx.rank(queue_multi_idx.project<by_time>(it));
         result.emplace_back(pos, *it);
     }
 
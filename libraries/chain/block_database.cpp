@@ -22,6 +22,8 @@
  * THE SOFTWARE.
  */
 #include <graphene/chain/block_database.hpp>
+#include <graphene/chain/mapped_file.hpp>
+#include <graphene/chain/segmented_block_log.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/smart_ref_impl.hpp>
@@ -39,38 +41,136 @@ FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
 
 namespace graphene { namespace chain {
 
-void block_database::open( const fc::path& dbdir )
+block_database::block_database(){}
+block_database::~block_database(){}
+
+void block_database::open( const fc::path& dbdir, const block_database_options& options )
 { try {
    fc::create_directories(dbdir);
+   _options = options;
    _block_num_to_pos.exceptions(std::ios_base::failbit | std::ios_base::badbit);
    _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
 
    _index_filename = dbdir / "index";
+   _blocks_filename = dbdir / "blocks";
+   FC_ASSERT( _options.segmented || _options.retain_blocks == 0, "Only the segmented block log can be pruned" );
+   if( _options.segmented )
+   {
+      const fc::path segments_dir = dbdir / "segments";
+      const fc::path import_dir = dbdir / "segments.import";
+      const fc::path imported_index = dbdir / "index.imported";
+      if( fc::exists( imported_index ) )
+      {
+         // An import finished, but did not get to move the segments into place or delete the old files
+         if( fc::exists( import_dir ) )
+         {
+            fc::remove_all( segments_dir );
+            fc::rename( import_dir, segments_dir );
+            detail::sync_to_disk( dbdir );
+         }
+         fc::remove( _blocks_filename );
+         fc::remove( imported_index );
+      }
+      else if( fc::exists( import_dir ) )
+      {
+         wlog( "Discarding the block log segments of an interrupted import in ${d}", ("d", import_dir) );
+         fc::remove_all( import_dir );
+      }
+      if( fc::exists( _index_filename ) )
+         import_into_segments( segments_dir, import_dir, imported_index );
+      _segments.reset( new segmented_block_log( segments_dir, _options.blocks_per_segment, _options.compress ) );
+      return;
+   }
+
    if( !fc::exists( _index_filename ) )
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
+     _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
    }
    else
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+     _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+   }
+
+   if( _options.memory_mapped )
+   {
+      _mapped_index.reset( new detail::mapped_file( _index_filename ) );
+      _mapped_blocks.reset( new detail::mapped_file( _blocks_filename ) );
    }
 } FC_CAPTURE_AND_RETHROW( (dbdir) ) }
 
+void block_database::import_into_segments( const fc::path& segments_dir, const fc::path& import_dir,
+                                           const fc::path& imported_index )
+{ try {
+   if( fc::exists( segments_dir ) )
+      FC_ASSERT( segmented_block_log( segments_dir, _options.blocks_per_segment, _options.compress ).empty(),
+                 "Found both a single-file block log and segments in ${d}", ("d", _index_filename.parent_path()) );
+   ilog( "Moving blocks from ${f} into block log segments...", ("f", _blocks_filename) );
+   _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in );
+   _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in );
+
+   {
+      segmented_block_log segments( import_dir, _options.blocks_per_segment, _options.compress );
+      const uint32_t count = fc::file_size( _index_filename ) / sizeof(index_entry);
+      index_entry e;
+      vector<char> data;
+      for( uint32_t block_num = 1; block_num < count; ++block_num )
+      {
+         if( block_num % 100000 == 0 )
+            ilog( "   ${n} of ${c}", ("n", block_num)("c", count) );
+         FC_ASSERT( read_index_entry( block_num, e ) );
+         if( e.block_size == 0 )
+            continue;
+         read_block_data( e, data );
+         segments.store( e.block_id, data );
+      }
+      segments.flush();
+   }
+   // The segments and the directory entries of the import have to be on disk before the index is renamed,
+   // otherwise open() could find the import complete but its segments lost
+   const fc::path dbdir = _index_filename.parent_path();
+   for( fc::directory_iterator itr( import_dir ); itr != fc::directory_iterator(); ++itr )
+      detail::sync_to_disk( *itr );
+   detail::sync_to_disk( import_dir );
+   detail::sync_to_disk( dbdir );
+
+   _blocks.close();
+   _block_num_to_pos.close();
+
+   // Renaming the index away marks the import as complete, open() finishes the steps after it if they are
+   // interrupted, and discards the import directory if this point was never reached
+   fc::rename( _index_filename, imported_index );
+   detail::sync_to_disk( dbdir );
+   fc::remove_all( segments_dir );
+   fc::rename( import_dir, segments_dir );
+   detail::sync_to_disk( dbdir );
+   fc::remove( _blocks_filename );
+   fc::remove( imported_index );
+   ilog( "Done moving blocks into segments" );
+} FC_CAPTURE_AND_RETHROW( (segments_dir)(import_dir) ) }
+
 bool block_database::is_open()const
 {
-  return _blocks.is_open();
+  return _segments || _blocks.is_open();
 }
 
 void block_database::close()
 {
+  _segments.reset();
+  _mapped_index.reset();
+  _mapped_blocks.reset();
   _blocks.close();
   _block_num_to_pos.close();
 }
 
 void block_database::flush()
 {
+  if( _segments )
+  {
+     _segments->flush();
+     return;
+  }
   _blocks.flush();
   _block_num_to_pos.flush();
 }
@@ -83,6 +183,11 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
       id = b.id();
       elog( "id argument of block_database::store() was not initialized for block ${id}", ("id", id) );
    }
+   if( _segments )
+   {
+      _segments->store( id, fc::raw::pack( b ) );
+      return;
+   }
    _block_num_to_pos.seekp( sizeof( index_entry ) * int64_t(block_header::num_from_id(id)) );
    index_entry e;
    _blocks.seekp( 0, _blocks.end );
@@ -92,10 +197,25 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
    e.block_id   = id;
    _blocks.write( vec.data(), vec.size() );
    _block_num_to_pos.write( (char*)&e, sizeof(e) );
+
+   // Mapped readers see the files through the page cache, so the stream buffers have to be
+   // written out before the index entry can be looked up. The blocks go first so a reader never
+   // finds an index entry pointing past the end of the blocks file.
+   if( _options.memory_mapped )
+   {
+      _blocks.flush();
+      _block_num_to_pos.flush();
+   }
 }
 
 void block_database::remove( const block_id_type& id )
 { try {
+   if( _segments )
+   {
+      _segments->remove( id );
+      return;
+   }
+
    index_entry e;
    int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
    _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
@@ -110,21 +230,94 @@ void block_database::remove( const block_id_type& id )
       e.block_size = 0;
       _block_num_to_pos.seekp( sizeof(e) * int64_t(block_header::num_from_id(id)) );
       _block_num_to_pos.write( (char*)&e, sizeof(e) );
+      if( _options.memory_mapped )
+         _block_num_to_pos.flush();
    }
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
-bool block_database::contains( const block_id_type& id )const
+bool block_database::read_index_entry( uint32_t block_num, index_entry& e )const
 {
-   if( id == block_id_type() )
-      return false;
+   int64_t index_pos = sizeof(e) * int64_t(block_num);
+   if( _mapped_index )
+      return _mapped_index->read( index_pos, (char*)&e, sizeof(e) );
 
-   index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
    _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
    if ( _block_num_to_pos.tellg() < int64_t(index_pos + sizeof(e)) )
       return false;
    _block_num_to_pos.seekg( index_pos );
    _block_num_to_pos.read( (char*)&e, sizeof(e) );
+   return true;
+}
+
+void block_database::read_block_data( const index_entry& e, vector<char>& data )const
+{
+   data.resize( e.block_size );
+   if( _mapped_blocks )
+   {
+      FC_ASSERT( _mapped_blocks->read( e.block_pos, data.data(), e.block_size ),
+                 "Block data past the end of the blocks file (maybe corrupt on disk?)" );
+      return;
+   }
+
+   _blocks.seekg( e.block_pos );
+   if (e.block_size)
+      _blocks.read( data.data(), e.block_size );
+}
+
+bool block_database::read_stored_block( uint32_t block_num, block_id_type& id, vector<char>& data )const
+{
+   if( _segments )
+   {
+      segmented_block_log::entry e;
+      if( !_segments->read( block_num, e, &data ) )
+         return false;
+      id = e.block_id;
+      return true;
+   }
+
+   index_entry e;
+   if( !read_index_entry( block_num, e ) )
+      return false;
+   read_block_data( e, data );
+   if( _mapped_index )
+   {
+      index_entry after;
+      FC_ASSERT( read_index_entry( block_num, after ) && after.block_pos == e.block_pos &&
+                 after.block_size == e.block_size && after.block_id == e.block_id,
+                 "Index entry of block ${n} changed while it was read", ("n", block_num) );
+   }
+   id = e.block_id;
+   return true;
+}
+
+bool block_database::read_raw_block( uint32_t block_num, block_id_type& id, vector<char>& data )const
+{
+   if( !read_stored_block( block_num, id, data ) )
+      return false;
+   if( !data.empty() )
+   {
+      fc::datastream<const char*> ds( data.data(), data.size() );
+      signed_block_header header;
+      fc::raw::unpack( ds, header );
+      FC_ASSERT( header.id() == id, "Stored block ${n} does not match its index entry", ("n", block_num) );
+   }
+   return true;
+}
+
+bool block_database::contains( const block_id_type& id )const
+{
+   if( id == block_id_type() )
+      return false;
+
+   if( _segments )
+   {
+      segmented_block_log::entry e;
+      return _segments->read( block_header::num_from_id(id), e ) && e.block_id == id && e.stored_size > 0;
+   }
+
+   index_entry e;
+   if( !read_index_entry( block_header::num_from_id(id), e ) )
+      return false;
 
    return e.block_id == id && e.block_size > 0;
 }
@@ -132,40 +325,40 @@ bool block_database::contains( const block_id_type& id )const
 block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
    assert( block_num != 0 );
-   index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_num);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   block_id_type id;
+   bool found;
+   if( _segments )
+   {
+      segmented_block_log::entry e;
+      found = _segments->read( block_num, e );
+      id = e.block_id;
+   }
+   else
+   {
+      index_entry e;
+      found = read_index_entry( block_num, e );
+      id = e.block_id;
+   }
+   if( !found )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-   FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
-   return e.block_id;
+   FC_ASSERT( id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
+   return id;
 }
 
 optional<signed_block> block_database::fetch_optional( const block_id_type& id )const
 {
    try
    {
-      index_entry e;
-      int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
+      block_id_type stored_id;
+      vector<char> data;
+      if( !read_stored_block( block_header::num_from_id(id), stored_id, data ) )
          return {};
 
-      _block_num_to_pos.seekg( index_pos );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
+      if( stored_id != id ) return optional<signed_block>();
 
-      if( e.block_id != id ) return optional<signed_block>();
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      if (e.block_size)
-         _blocks.read( data.data(), e.block_size );
       auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
+      FC_ASSERT( result.id() == stored_id );
       return result;
    }
    catch (const fc::exception&)
@@ -181,20 +374,13 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
 {
    try
    {
-      index_entry e;
-      int64_t index_pos = sizeof(e) * int64_t(block_num);
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
+      block_id_type stored_id;
+      vector<char> data;
+      if( !read_stored_block( block_num, stored_id, data ) )
          return {};
 
-      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      _blocks.read( data.data(), e.block_size );
       auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
+      FC_ASSERT( result.id() == stored_id );
       return result;
    }
    catch (const fc::exception& e)
@@ -207,6 +393,47 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
+optional<vector<char>> block_database::fetch_raw( uint32_t block_num )const
+{
+   try
+   {
+      block_id_type stored_id;
+      vector<char> data;
+      if( !read_raw_block( block_num, stored_id, data ) || data.empty() )
+         return {};
+      return data;
+   }
+   catch (const fc::exception& e)
+   {
+       wlog("Error fetching raw block: " + e.to_string());
+   }
+   catch (const std::exception&)
+   {
+   }
+   return optional<vector<char>>();
+}
+
+optional<vector<char>> block_database::fetch_raw_optional( const block_id_type& id )const
+{
+   try
+   {
+      block_id_type stored_id;
+      vector<char> data;
+      if( !read_raw_block( block_header::num_from_id(id), stored_id, data ) )
+         return {};
+
+      if( stored_id != id || data.empty() ) return optional<vector<char>>();
+      return data;
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   return optional<vector<char>>();
+}
+
 optional<index_entry> block_database::last_index_entry()const {
    try
    {
@@ -246,6 +473,8 @@ optional<index_entry> block_database::last_index_entry()const {
             catch (const std::exception&)
             {
             }
+         if( _mapped_index )
+            _mapped_index->reset();
          fc::resize_file( _index_filename, pos );
       }
    }
@@ -260,6 +489,12 @@ optional<index_entry> block_database::last_index_entry()const {
 
 optional<signed_block> block_database::last()const
 {
+   if( _segments )
+   {
+      auto entry = _segments->last_entry();
+      if( entry.valid() ) return fetch_by_number( block_header::num_from_id(entry->block_id) );
+      return optional<signed_block>();
+   }
    optional<index_entry> entry = last_index_entry();
    if( entry.valid() ) return fetch_by_number( block_header::num_from_id(entry->block_id) );
    return optional<signed_block>();
@@ -267,9 +502,28 @@ optional<signed_block> block_database::last()const
 
 optional<block_id_type> block_database::last_id()const
 {
+   if( _segments )
+   {
+      auto entry = _segments->last_entry();
+      if( entry.valid() ) return entry->block_id;
+      return optional<block_id_type>();
+   }
    optional<index_entry> entry = last_index_entry();
    if( entry.valid() ) return entry->block_id;
    return optional<block_id_type>();
 }
 
+uint32_t block_database::first_block_num()const
+{
+   if( _segments )
+      return _segments->first_block_num();
+   return 1;
+}
+
+void block_database::prune( uint32_t first_kept_block )
+{
+   if( _segments )
+      _segments->prune( first_kept_block );
+}
+
 } }
@@ -0,0 +1,175 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <graphene/chain/block_prefetcher.hpp>
+#include <graphene/chain/block_database.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace chain {
+
+block_prefetcher::block_prefetcher( const block_database& blocks, uint32_t first, uint32_t last, size_t capacity,
+                                    bool with_merkle_roots, const optional<chain_id_type>& signature_chain_id )
+   : _blocks( blocks ), _first( first ), _last( last ), _capacity( std::max<size_t>( capacity, 1 ) ),
+     _with_merkle_roots( with_merkle_roots ), _next( first ), _signature_chain_id( signature_chain_id ),
+     _thread( "block_prefetch" )
+{
+   FC_ASSERT( first <= last, "Nothing to prefetch", ("first", first)("last", last) );
+   if( _signature_chain_id.valid() )
+      _signature_pool.reset( new graphene::db::worker_pool() );
+   _reader = _thread.async( [this]() { read_blocks(); }, "read_blocks" );
+}
+
+block_prefetcher::~block_prefetcher()
+{
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _stop = true;
+   }
+   _not_full.notify_all();
+   try
+   {
+      _reader.wait();
+   }
+   catch( const fc::exception& e )
+   {
+      wlog( "block prefetch failed: ${e}", ("e", e.to_detail_string()) );
+   }
+   _thread.quit();
+}
+
+void block_prefetcher::read_blocks()
+{
+   try
+   {
+      // the pool's threads need several blocks' signatures to share
+      const size_t batch_size = _signature_pool ? std::min<size_t>( _capacity, 64 ) : 1;
+      vector<optional<prefetched_block>> batch;
+      uint32_t num = _first;
+      bool more = true;
+      while( more )
+      {
+         batch.clear();
+         while( more && batch.size() < batch_size )
+         {
+            batch.push_back( read_block( num ) );
+            more = batch.back().valid() && num++ < _last;
+         }
+         if( _signature_pool )
+            recover_signature_keys( batch );
+         for( auto& item : batch )
+         {
+            if( !push( std::move( item ) ) )
+            {
+               more = false;
+               break;
+            }
+         }
+      }
+   }
+   catch( ... )
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _error = std::current_exception();
+   }
+   std::lock_guard<std::mutex> lock( _mutex );
+   _done = true;
+   _not_empty.notify_one();
+}
+
+optional<prefetched_block> block_prefetcher::read_block( uint32_t num )const
+{
+   optional<prefetched_block> item;
+   optional<signed_block> block = _blocks.fetch_by_number( num );
+   if( block.valid() )
+   {
+      item = prefetched_block();
+      item->digests = block_digests( *block, _with_merkle_roots );
+      item->block = std::move( *block );
+   }
+   return item;
+}
+
+void block_prefetcher::recover_signature_keys( const vector<optional<prefetched_block>>& batch )
+{
+   // one task per signed block header and per transaction, -1 stands for the header
+   vector<std::pair<const signed_block*, int32_t>> tasks;
+   for( const auto& item : batch )
+   {
+      if( !item.valid() )
+         continue;
+      tasks.emplace_back( &item->block, -1 );
+      for( size_t t = 0; t < item->block.transactions.size(); ++t )
+         tasks.emplace_back( &item->block, int32_t( t ) );
+   }
+   _signature_pool->run( tasks.size(), [this, &tasks]( size_t i ) {
+      const signed_block& block = *tasks[i].first;
+      try
+      {
+         if( tasks[i].second < 0 )
+            block.signee();
+         else
+            block.transactions[tasks[i].second].precompute_signature_keys( *_signature_chain_id );
+      }
+      catch( const fc::exception& )
+      {
+         // applying the block recovers the keys again and reports the error
+      }
+   } );
+}
+
+bool block_prefetcher::push( optional<prefetched_block>&& item )
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   _not_full.wait( lock, [this]() { return _stop || _queue.size() < _capacity; } );
+   if( _stop )
+      return false;
+   _queue.push_back( std::move( item ) );
+   _not_empty.notify_one();
+   return true;
+}
+
+optional<prefetched_block> block_prefetcher::next()
+{
+   FC_ASSERT( _next <= _last, "All prefetched blocks were returned", ("last", _last) );
+   std::unique_lock<std::mutex> lock( _mutex );
+   _not_empty.wait( lock, [this]() { return !_queue.empty() || _done; } );
+   if( _queue.empty() )
+   {
+      if( _error )
+         std::rethrow_exception( _error );
+      FC_THROW( "Block prefetch stopped before block ${n}", ("n", _next) );
+   }
+   optional<prefetched_block> item = std::move( _queue.front() );
+   _queue.pop_front();
+   lock.unlock();
+   _not_full.notify_one();
+   ++_next;
+   return item;
+}
+
+} } // graphene::chain
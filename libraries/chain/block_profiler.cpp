@@ -0,0 +1,219 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <graphene/chain/block_profiler.hpp>
+#include <graphene/chain/protocol/operations.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+const char* const phase_names[phase_count] = {
+   "header",
+   "transactions",
+   "global_dynamic_data",
+   "maintenance",
+   "clear_expired",
+   "witness_schedule",
+   "reset_spending_limits",
+   "mint_dascoin_rewards",
+   "daspay_clearing",
+   "delayed_operations",
+   "notify"
+};
+
+struct operation_name_visitor
+{
+   typedef std::string result_type;
+
+   template<typename Operation>
+   std::string operator()( const Operation& )const
+   {
+      const std::string name = fc::get_typename<Operation>::name();
+      const auto pos = name.rfind( "::" );
+      return pos == std::string::npos ? name : name.substr( pos + 2 );
+   }
+};
+
+const std::string& operation_name( int operation_type )
+{
+   static const std::vector<std::string> names = []() {
+      std::vector<std::string> result;
+      operation op;
+      for( int i = 0; i < operation::count(); ++i )
+      {
+         op.set_which( i );
+         result.push_back( op.visit( operation_name_visitor() ) );
+      }
+      return result;
+   }();
+   return names.at( operation_type );
+}
+
+uint64_t to_us( uint64_t ns ) { return ns / 1000; }
+
+}
+
+const size_t timing_histogram::bucket_count;
+const uint32_t block_profiler::default_window_blocks;
+
+void timing_histogram::add( uint64_t ns )
+{
+   if( buckets.empty() )
+      buckets.resize( bucket_count );
+   uint64_t us = to_us( ns );
+   size_t bucket = 0;
+   while( us > 0 && bucket < bucket_count - 1 )
+   {
+      us >>= 1;
+      ++bucket;
+   }
+   ++buckets[bucket];
+   ++count;
+   total_ns += ns;
+   max_ns = std::max( max_ns, ns );
+}
+
+void timing_histogram::merge( const timing_histogram& other )
+{
+   if( other.count == 0 )
+      return;
+   if( buckets.empty() )
+      buckets.resize( bucket_count );
+   for( size_t i = 0; i < other.buckets.size(); ++i )
+      buckets[i] += other.buckets[i];
+   count += other.count;
+   total_ns += other.total_ns;
+   max_ns = std::max( max_ns, other.max_ns );
+}
+
+block_profiler::window::window()
+   : phases( phase_count ), evaluate( operation::count() ), apply( operation::count() )
+{}
+
+block_profiler::block_profiler()
+   : _block_phases( phase_count ), _last_block_phases( phase_count )
+{}
+
+void block_profiler::set_window_blocks( uint32_t blocks )
+{
+   FC_ASSERT( blocks > 0 );
+   std::lock_guard<std::mutex> lock( _mutex );
+   _window_blocks = blocks;
+   _current = window();
+   _previous = window();
+}
+
+void block_profiler::begin_block()
+{
+   _in_block = true;
+   if( !_enabled )
+      return;
+   std::fill( _block_phases.begin(), _block_phases.end(), 0 );
+   _block_evaluate.clear();
+   _block_apply.clear();
+   _block_start = clock::now();
+}
+
+void block_profiler::end_block( uint32_t block_num )
+{
+   if( !_in_block )
+      return;
+   _in_block = false;
+   if( !_enabled )
+      return;
+   const uint64_t total_ns = elapsed_ns( _block_start );
+
+   std::lock_guard<std::mutex> lock( _mutex );
+   _current.total.add( total_ns );
+   for( int p = 0; p < phase_count; ++p )
+      _current.phases[p].add( _block_phases[p] );
+   for( const auto& sample : _block_evaluate )
+      _current.evaluate[sample.first].add( sample.second );
+   for( const auto& sample : _block_apply )
+      _current.apply[sample.first].add( sample.second );
+   if( ++_current.blocks >= _window_blocks )
+   {
+      _previous = std::move( _current );
+      _current = window();
+   }
+
+   // kept as recorded, get_last_block() names the phases and operations
+   _last_block_num = block_num;
+   _last_block_ns = total_ns;
+   std::swap( _last_block_phases, _block_phases );
+   std::swap( _last_block_evaluate, _block_evaluate );
+   std::swap( _last_block_apply, _block_apply );
+}
+
+void block_profiler::abort_block()
+{
+   // the partial timings are cleared by the next begin_block()
+   _in_block = false;
+}
+
+block_profile block_profiler::get_last_block()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   block_profile result;
+   result.block_num = _last_block_num;
+   result.total_us = to_us( _last_block_ns );
+   for( size_t p = 0; p < _last_block_phases.size(); ++p )
+      result.phases[phase_names[p]] = to_us( _last_block_phases[p] );
+   for( const auto& sample : _last_block_evaluate )
+      result.operations[operation_name( sample.first )] += to_us( sample.second );
+   for( const auto& sample : _last_block_apply )
+      result.operations[operation_name( sample.first )] += to_us( sample.second );
+   return result;
+}
+
+block_profile_stats block_profiler::get_stats()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   block_profile_stats result;
+   result.window_blocks = _window_blocks;
+   for( const window* w : { &_previous, &_current } )
+   {
+      result.blocks += w->blocks;
+      result.total.merge( w->total );
+      for( int p = 0; p < phase_count; ++p )
+         if( w->phases[p].count > 0 )
+            result.phases[phase_names[p]].merge( w->phases[p] );
+      for( size_t i = 0; i < w->evaluate.size(); ++i )
+      {
+         if( w->evaluate[i].count > 0 )
+            result.evaluate[operation_name( i )].merge( w->evaluate[i] );
+         if( w->apply[i].count > 0 )
+            result.apply[operation_name( i )].merge( w->apply[i] );
+      }
+   }
+   return result;
+}
+
+} } // graphene::chain
@@ -111,6 +111,31 @@ optional<signed_block_with_virtual_operations> database::fetch_block_with_virtua
    return ret_v;
 }
 
+optional<vector<char>> database::fetch_raw_block_by_id( const block_id_type& id )const
+{
+   return _block_id_to_block.fetch_raw_optional( id );
+}
+
+optional<vector<char>> database::fetch_raw_block_by_number( uint32_t num )const
+{
+   return _block_id_to_block.fetch_raw( num );
+}
+
+uint32_t database::first_stored_block_num()const
+{
+   return _block_id_to_block.first_block_num();
+}
+
+optional<state_hashes> database::get_state_hashes( uint32_t block_num )const
+{
+   if( block_num == head_block_num() && ( _state_hash_history.empty() || _state_hash_history.back().block_num != block_num ) )
+      return head_state_hashes();
+   for( auto itr = _state_hash_history.rbegin(); itr != _state_hash_history.rend(); ++itr )
+      if( itr->block_num == block_num )
+         return *itr;
+   return optional<state_hashes>();
+}
+
 const signed_transaction& database::get_recent_transaction(const transaction_id_type& trx_id) const
 {
    auto& index = get_index_type<transaction_index>().indices().get<by_trx_id>();
@@ -152,7 +177,21 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
       detail::without_pending_transactions( *this, std::move(_pending_tx),
       [&]()
       {
+         const uint32_t last_irreversible_block = get_dynamic_global_properties().last_irreversible_block_num;
          result = _push_block(new_block);
+         // pruned outside the block's undo session, which cannot bring back the removed blocks. The block log
+         // only needs pruning when more blocks become irreversible, reindex() prunes once at its end
+         if( !_reindexing && get_dynamic_global_properties().last_irreversible_block_num > last_irreversible_block )
+            prune_block_log();
+         // the block is in by now, a failed checkpoint leaves the journal as it is until the next one
+         try
+         {
+            checkpoint_journal();
+         }
+         catch( const fc::exception& e )
+         {
+            elog( "Failed to checkpoint the state journal: ${e}", ("e", e.to_detail_string()) );
+         }
       });
    });
    return result;
@@ -194,6 +233,7 @@ bool database::_push_block(const signed_block& new_block)
                    apply_block( (*ritr)->data, skip );
                    _block_id_to_block.store( (*ritr)->id, (*ritr)->data );
                    session.commit();
+                   record_head_state();
                 }
                 catch ( const fc::exception& e ) { except = e; }
                 if( except )
@@ -224,6 +264,7 @@ bool database::_push_block(const signed_block& new_block)
                       apply_block( (*ritr2)->data, skip );
                       _block_id_to_block.store( (*ritr2)->id, (*ritr2)->data );
                       session.commit();
+                      record_head_state();
                    }
                    throw *except;
                 }
@@ -234,16 +275,18 @@ bool database::_push_block(const signed_block& new_block)
       }
    }
 
+   const block_digests digests( new_block, !(skip & skip_merkle_check) );
    try {
       auto session = _undo_db.start_undo_session();
-      apply_block(new_block, skip);
-      _block_id_to_block.store(new_block.id(), new_block);
+      apply_block(new_block, skip, digests);
+      _block_id_to_block.store(digests.id, new_block);
       session.commit();
    } catch ( const fc::exception& e ) {
       elog("Failed to push new block:\n${e}", ("e", e.to_detail_string()));
-      _fork_db.remove(new_block.id());
+      _fork_db.remove(digests.id);
       throw;
    }
+   record_head_state();
 
    return false;
 } FC_CAPTURE_AND_RETHROW( (new_block) ) }
@@ -298,6 +341,22 @@ processed_transaction database::validate_transaction( const signed_transaction&
    return _apply_transaction( trx );
 }
 
+void database::precompute_signature_keys( const vector<const signed_transaction*>& transactions )
+{
+   if( transactions.size() < 2 || (get_node_properties().skip_flags & (skip_transaction_signatures | skip_authority_check)) )
+      return;
+   if( !_signature_pool )
+      _signature_pool.reset( new worker_pool() );
+   const chain_id_type& chain_id = get_chain_id();
+   _signature_pool->run( transactions.size(), [&]( size_t i ) {
+      try {
+         transactions[i]->precompute_signature_keys( chain_id );
+      } catch( const fc::exception& ) {
+         // verify_authority() recovers the keys again and reports the error
+      }
+   });
+}
+
 processed_transaction database::push_proposal(const proposal_object& proposal)
 { try {
    transaction_evaluation_state eval_state(this);
@@ -447,7 +506,8 @@ signed_block database::_generate_block(
       FC_ASSERT( fc::raw::pack_size(pending_block) <= get_global_properties().parameters.maximum_block_size );
    }
 
-   push_block( pending_block, skip );
+   // the merkle root was just computed from these transactions
+   push_block( pending_block, skip | skip_merkle_check );
 
    return pending_block;
 } FC_CAPTURE_AND_RETHROW( (witness_id) ) }
@@ -465,11 +525,54 @@ void database::pop_block()
 
    _fork_db.pop_block();
    pop_undo();
+   record_head_state();
 
    _popped_tx.insert( _popped_tx.begin(), head_block->transactions.begin(), head_block->transactions.end() );
 
 } FC_CAPTURE_AND_RETHROW() }
 
+state_hashes database::head_state_hashes()const
+{
+   state_hashes hashes;
+   hashes.block_num = head_block_num();
+   hashes.block_id = head_block_id();
+   hashes.indices = get_index_hashes();
+   hashes.state_hash = get_state_hash( hashes.indices );
+   return hashes;
+}
+
+void database::record_head_state()
+{
+   const uint32_t head_num = head_block_num();
+   object_database::journal_commit( head_num, get_dynamic_global_properties().last_irreversible_block_num );
+
+   if( !state_hash_tracking() )
+      return;
+   // after a pop the entries of the popped blocks are gone and the head's one is recomputed
+   while( !_state_hash_history.empty() && _state_hash_history.back().block_num >= head_num )
+      _state_hash_history.pop_back();
+   _state_hash_history.push_back( head_state_hashes() );
+   while( _state_hash_history.size() > state_hash_history_size )
+      _state_hash_history.pop_front();
+}
+
+void database::checkpoint_journal()
+{ try {
+   const uint32_t last_irreversible_block = get_dynamic_global_properties().last_irreversible_block_num;
+   // a replay has no undo history below its last blocks to rewind with, it flushes on its own instead
+   if( _reindexing || !journal_enabled() || journal_suspended() || _journal_checkpoint_blocks == 0 ||
+       last_irreversible_block < _journal_checkpoint_block + _journal_checkpoint_blocks )
+      return;
+
+   // a flushed state is opened without undo history, so it must not hold blocks that could still be popped. Every
+   // reversible block has its undo state, the state is written as it was before them.
+   const uint32_t reversible_blocks = head_block_num() - last_irreversible_block;
+   if( _undo_db.size() < reversible_blocks )
+      return;
+   with_undo_states_rewound( reversible_blocks, [this]() { object_database::flush(); } );
+   _journal_checkpoint_block = last_irreversible_block;
+} FC_CAPTURE_AND_RETHROW() }
+
 void database::clear_pending()
 { try {
    assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
@@ -506,13 +609,18 @@ const vector<optional< operation_history_object > >& database::get_applied_opera
 //////////////////// private methods ////////////////////
 
 void database::apply_block( const signed_block& next_block, uint32_t skip )
+{
+   apply_block( next_block, skip, block_digests( next_block, !(skip & skip_merkle_check) ) );
+}
+
+void database::apply_block( const signed_block& next_block, uint32_t skip, const block_digests& digests )
 {
    auto block_num = next_block.block_num();
    if( _checkpoints.size() && _checkpoints.rbegin()->second != block_id_type() )
    {
       auto itr = _checkpoints.find( block_num );
       if( itr != _checkpoints.end() )
-         FC_ASSERT( next_block.id() == itr->second, "Block did not match checkpoint", ("checkpoint",*itr)("block_id",next_block.id()) );
+         FC_ASSERT( digests.id == itr->second, "Block did not match checkpoint", ("checkpoint",*itr)("block_id",digests.id) );
 
       if( _checkpoints.rbegin()->first >= block_num )
          skip = ~0;// WE CAN SKIP ALMOST EVERYTHING
@@ -520,7 +628,7 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
 
    detail::with_skip_flags( *this, skip, [&]()
    {
-      _apply_block( next_block );
+      _apply_block( next_block, digests );
    } );
    return;
 }
@@ -555,16 +663,26 @@ vector<optional< operation_history_object > > database::get_virtual_ops_and_clea
    return std::move(ret);
 }
 
-void database::_apply_block( const signed_block& next_block )
+void database::_apply_block( const signed_block& next_block, const block_digests& digests )
 { try {
    uint32_t next_block_num = next_block.block_num();
    uint32_t skip = get_node_properties().skip_flags;
+   block_profiler::scoped_block profiled_block( _block_profiler );
    applied_ops_to_virtual_ops();
    _applied_ops.clear();
 
-   FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root == next_block.calculate_merkle_root(), "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",next_block.calculate_merkle_root())("next_block",next_block)("id",next_block.id()) );
+   const witness_object* signing_witness_ptr = nullptr;
+   {
+      block_profiler::scoped_phase timer( _block_profiler, phase_header );
+      if( !(skip & skip_merkle_check) )
+      {
+         const checksum_type merkle_root = digests.merkle_root ? *digests.merkle_root : next_block.calculate_merkle_root();
+         FC_ASSERT( next_block.transaction_merkle_root == merkle_root, "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",merkle_root)("next_block",next_block)("id",digests.id) );
+      }
 
-   const witness_object& signing_witness = validate_block_header(skip, next_block);
+      signing_witness_ptr = &validate_block_header(skip, next_block);
+   }
+   const witness_object& signing_witness = *signing_witness_ptr;
    const auto& global_props = get_global_properties();
    const auto& dynamic_global_props = get<dynamic_global_property_object>(dynamic_global_property_id_type());
    bool maint_needed = (dynamic_global_props.next_maintenance_time <= next_block.timestamp);
@@ -572,61 +690,97 @@ void database::_apply_block( const signed_block& next_block )
    _current_block_num    = next_block_num;
    _current_trx_in_block = 0;
 
-   for( const auto& trx : next_block.transactions )
+   // the signatures of a block's transactions are not checked again, unless a replay verifies them
+   const uint32_t trx_skip = _verify_block_transaction_signatures ? skip : skip | skip_transaction_signatures;
    {
-      /* We do not need to push the undo state for each transaction
-       * because they either all apply and are valid or the
-       * entire block fails to apply.  We only need an "undo" state
-       * for transactions when validating broadcast transactions or
-       * when building a block.
-       */
-      apply_transaction( trx, skip | skip_transaction_signatures );
-      ++_current_trx_in_block;
+      block_profiler::scoped_phase timer( _block_profiler, phase_transactions );
+      for( const auto& trx : next_block.transactions )
+      {
+         /* We do not need to push the undo state for each transaction
+          * because they either all apply and are valid or the
+          * entire block fails to apply.  We only need an "undo" state
+          * for transactions when validating broadcast transactions or
+          * when building a block.
+          */
+         detail::with_skip_flags( *this, trx_skip, [&]()
+         {
+            _apply_transaction( trx, digests.transaction_ids[_current_trx_in_block] );
+         });
+         ++_current_trx_in_block;
+      }
    }
 
-   update_global_dynamic_data(next_block);
-   update_signing_witness(signing_witness, next_block);
-   update_last_irreversible_block();
+   {
+      block_profiler::scoped_phase timer( _block_profiler, phase_global_dynamic_data );
+      update_global_dynamic_data(next_block, digests.id);
+      update_signing_witness(signing_witness, next_block);
+      update_last_irreversible_block();
+   }
 
    // Are we at the maintenance interval?
    if( maint_needed )
+   {
+      block_profiler::scoped_phase timer( _block_profiler, phase_maintenance );
       perform_chain_maintenance(next_block, global_props);
+   }
 
-   create_block_summary(next_block);
-   clear_expired_transactions();
-   clear_expired_proposals();
-   clear_expired_orders();
-   update_expired_feeds();
-   update_withdraw_permissions();
+   {
+      block_profiler::scoped_phase timer( _block_profiler, phase_clear_expired );
+      create_block_summary(next_block, digests.id);
+      clear_expired_transactions();
+      clear_expired_proposals();
+      clear_expired_orders();
+      update_expired_feeds();
+      update_withdraw_permissions();
+   }
 
-   // n.b., update_maintenance_flag() happens this late
-   // because get_slot_time() / get_slot_at_time() is needed above
-   // TODO:  figure out if we could collapse this function into
-   // update_global_dynamic_data() as perhaps these methods only need
-   // to be called for header validation?
-   update_maintenance_flag( maint_needed );
-   update_witnesses();
-   update_witness_schedule();
+   {
+      block_profiler::scoped_phase timer( _block_profiler, phase_witness_schedule );
+      // n.b., update_maintenance_flag() happens this late
+      // because get_slot_time() / get_slot_at_time() is needed above
+      // TODO:  figure out if we could collapse this function into
+      // update_global_dynamic_data() as perhaps these methods only need
+      // to be called for header validation?
+      update_maintenance_flag( maint_needed );
+      update_witnesses();
+      update_witness_schedule();
+   }
 
-   reset_spending_limits();
+   {
+      block_profiler::scoped_phase timer( _block_profiler, phase_reset_spending_limits );
+      reset_spending_limits();
+   }
 
    if ( global_props.parameters.enable_dascoin_queue )
+   {
+      block_profiler::scoped_phase timer( _block_profiler, phase_mint_dascoin_rewards );
       mint_dascoin_rewards();
+   }
 
    if ( global_props.daspay_parameters.clearing_enabled )
-     daspay_clearing_start();
+   {
+      block_profiler::scoped_phase timer( _block_profiler, phase_daspay_clearing );
+      daspay_clearing_start();
+   }
 
    if ( global_props.delayed_operations_resolver_enabled )
-     resolve_delayed_operations();
+   {
+      block_profiler::scoped_phase timer( _block_profiler, phase_delayed_operations );
+      resolve_delayed_operations();
+   }
 
-   if( !_node_property_object.debug_updates.empty() )
-      apply_debug_updates();
+   {
+      block_profiler::scoped_phase timer( _block_profiler, phase_notify );
+      if( !_node_property_object.debug_updates.empty() )
+         apply_debug_updates();
 
-   // notify observers that the block has been applied
-   notify_applied_block( next_block ); //emit
-   _applied_ops.clear();
+      // notify observers that the block has been applied
+      notify_applied_block( next_block ); //emit
+      _applied_ops.clear();
 
-   notify_changed_objects();
+      notify_changed_objects();
+   }
+   profiled_block.end( next_block_num );
 } FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
 
 processed_transaction database::apply_transaction(const signed_transaction& trx, uint32_t skip)
@@ -640,6 +794,11 @@ processed_transaction database::apply_transaction(const signed_transaction& trx,
 }
 
 processed_transaction database::_apply_transaction(const signed_transaction& trx)
+{
+   return _apply_transaction( trx, trx.id() );
+}
+
+processed_transaction database::_apply_transaction(const signed_transaction& trx, const transaction_id_type& trx_id)
 { try {
    uint32_t skip = get_node_properties().skip_flags;
 
@@ -648,7 +807,6 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
 
    auto& trx_idx = get_mutable_index_type<transaction_index>();
    const chain_id_type& chain_id = get_chain_id();
-   auto trx_id = trx.id();
    FC_ASSERT( (skip & skip_transaction_dupe_check) ||
               trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end() );
    transaction_evaluation_state eval_state(this);
@@ -659,6 +817,8 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    {
       auto get_active = [&]( account_id_type id ) { return &id(*this).active; };
       auto get_owner  = [&]( account_id_type id ) { return &id(*this).owner;  };
+      // kept with the transaction, so re-applying it from the pending queue needs no recovery
+      trx.precompute_signature_keys( chain_id );
       trx.verify_authority( chain_id, get_active, get_owner, get_global_properties().parameters.max_authority_depth );
    }
 
@@ -750,11 +910,11 @@ const witness_object& database::validate_block_header( uint32_t skip, const sign
    return witness;
 }
 
-void database::create_block_summary(const signed_block& next_block)
+void database::create_block_summary(const signed_block& next_block, const block_id_type& next_block_id)
 {
    block_summary_id_type sid(next_block.block_num() & 0xffff );
    modify( sid(*this), [&](block_summary_object& p) {
-         p.block_id = next_block.id();
+         p.block_id = next_block_id;
    });
 }
 
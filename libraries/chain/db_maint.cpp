@@ -39,6 +39,7 @@
 #include <graphene/chain/committee_member_object.hpp>
 #include <graphene/chain/fba_object.hpp>
 #include <graphene/chain/global_property_object.hpp>
+#include <graphene/chain/license_objects.hpp>
 #include <graphene/chain/market_object.hpp>
 #include <graphene/chain/special_authority_object.hpp>
 #include <graphene/chain/upgrade_event_object.hpp>
@@ -752,12 +753,8 @@ void database::perform_upgrades(const account_object& account, const upgrade_eve
    modify(license_info_obj, [&](license_information_object& lio) {
       for (auto& license_history : lio.history)
       {
-         auto upgrade_it = std::find_if(license_history.upgrades.begin(), license_history.upgrades.end(),
-                                        [&upgrade](const pair<upgrade_event_id_type, time_point_sec>& upgrade_and_time){
-                                            return upgrade_and_time.first == upgrade.id;
-                                      });
          // If not upgraded by this upgrade, proceed with it:
-         if ( license_history.upgrades.end() == upgrade_it && license_history.balance_upgrade.has_remaining_upgrades() )
+         if ( !license_history.upgraded_by(upgrade.id) && license_history.balance_upgrade.has_remaining_upgrades() )
          {
             // If the license has been issued before the cutoff time, execute it:
             if ( license_history.activated_at <= cutoff_time )
@@ -794,7 +791,7 @@ void database::perform_upgrades(const account_object& account, const upgrade_eve
                      update_balance = true;
                   }
                }
-               license_history.upgrades.emplace_back(std::make_pair(upgrade.id, head_block_time()));
+               license_history.add_upgrade(upgrade.id, head_block_time());
             }
          }
       }
@@ -812,19 +809,6 @@ void database::perform_upgrades(const account_object& account, const upgrade_eve
 
 void database::perform_upgrades()
 {
-   class perform_upgrades_helper
-   {
-   public:
-     explicit perform_upgrades_helper(database& d, const upgrade_event_object& upgrade)
-         : d(d), upgrade(upgrade) {}
-
-     void operator()(const account_object& a) { d.perform_upgrades(a, upgrade); }
-
-   private:
-     database& d;
-     const upgrade_event_object& upgrade;
-   };
-
    // Helper lambda which returns true if upgrade should be executed:
    const auto should_execute_upgrade_event = [this](const upgrade_event_object& upgrade) -> bool {
      // If executed already, do not execute:
@@ -843,7 +827,22 @@ void database::perform_upgrades()
      return false;
    };
 
-   optional<upgrade_event_object> last_upgrade{};
+   // Only accounts with license information can be upgraded, they are collected once for all the due events.
+   // They are upgraded in name order, which is the order the queue submissions of chartered licenses are made in:
+   vector<const account_object*> licensed_accounts;
+   const auto collect_licensed_accounts = [&]() {
+      const auto& license_idx = get_index_type<license_information_index>().indices().get<by_id>();
+      licensed_accounts.reserve(license_idx.size());
+      for ( const auto& lio : license_idx )
+      {
+         const auto& account = lio.account(*this);
+         if ( account.license_information.valid() && *account.license_information == lio.get_id() )
+            licensed_accounts.push_back(&account);
+      }
+      std::sort(licensed_accounts.begin(), licensed_accounts.end(),
+                [](const account_object* a, const account_object* b) { return a->name < b->name; });
+   };
+
    const auto& idx = get_index_type<upgrade_event_index>().indices().get<by_id>();
    for ( auto it = idx.cbegin(); it != idx.cend(); ++it )
    {
@@ -854,10 +853,140 @@ void database::perform_upgrades()
          obj.num_of_executions++;
       });
 
-      last_upgrade = *it;
-      perform_upgrades_helper upgrades_helper(*this, *it);
-      perform_helpers<account_index, by_name>(std::tie(upgrades_helper));
+      if ( licensed_accounts.empty() )
+         collect_licensed_accounts();
+      for ( const account_object* account : licensed_accounts )
+         perform_upgrades(*account, *it);
+   }
+}
+
+namespace {
+
+/// The stake behind every vote and witness and committee count, summed over the accounts added to it
+struct vote_tally
+{
+   vector<uint64_t> votes;
+   vector<uint64_t> witness_counts;
+   vector<uint64_t> committee_counts;
+   uint64_t         total_voting_stake = 0;
+
+   explicit vote_tally(const global_property_object& props)
+      : votes(props.next_available_vote_id),
+        witness_counts(props.parameters.maximum_witness_count / 2 + 1),
+        committee_counts(props.parameters.maximum_committee_count / 2 + 1) {}
+
+   void add(const database& d, const global_property_object& props, const account_object& stake_account)
+   {
+      if( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) )
+      {
+         // There may be a difference between the account whose stake is voting and the one specifying opinions.
+         // Usually they're the same, but if the stake account has specified a voting_account, that account is the one
+         // specifying the opinions.
+         const account_object& opinion_account =
+               (stake_account.options.voting_account ==
+                GRAPHENE_PROXY_TO_SELF_ACCOUNT)? stake_account
+                                  : d.get(stake_account.options.voting_account);
+
+         const auto& stats = stake_account.statistics(d);
+         uint64_t voting_stake = stats.total_core_in_orders.value
+               + (stake_account.cashback_vb.valid() ? (*stake_account.cashback_vb)(d).balance.amount.value: 0)
+               + d.get_balance(stake_account.get_id(), asset_id_type()).amount.value;
+
+         for( vote_id_type id : opinion_account.options.votes )
+         {
+            uint32_t offset = id.instance();
+            // if they somehow managed to specify an illegal offset, ignore it.
+            if( offset < votes.size() )
+               votes[offset] += voting_stake;
+         }
+
+         if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
+         {
+            uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
+                                       witness_counts.size() - 1);
+            // votes for a number greater than maximum_witness_count
+            // are turned into votes for maximum_witness_count.
+            //
+            // in particular, this takes care of the case where a
+            // member was voting for a high number, then the
+            // parameter was lowered.
+            witness_counts[offset] += voting_stake;
+         }
+         if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
+         {
+            uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
+                                       committee_counts.size() - 1);
+            // votes for a number greater than maximum_committee_count
+            // are turned into votes for maximum_committee_count.
+            //
+            // same rationale as for witnesses
+            committee_counts[offset] += voting_stake;
+         }
+
+         total_voting_stake += voting_stake;
+      }
+   }
+
+   void merge(const vote_tally& other)
+   {
+      for( size_t i = 0; i < votes.size(); ++i )
+         votes[i] += other.votes[i];
+      for( size_t i = 0; i < witness_counts.size(); ++i )
+         witness_counts[i] += other.witness_counts[i];
+      for( size_t i = 0; i < committee_counts.size(); ++i )
+         committee_counts[i] += other.committee_counts[i];
+      total_voting_stake += other.total_voting_stake;
    }
+};
+
+/// Below this many accounts the tally is not worth handing to other threads
+const size_t parallel_vote_tally_min_accounts = 10000;
+
+/**
+ * Tallies the votes of all accounts on a worker_pool when none of them has fees to process. Processing fees deposits
+ * cashback, which changes the stake of the accounts tallied after it, so then nothing is tallied and false is
+ * returned, and the caller processes the fees and tallies the votes in one pass in name order. Each thread sums
+ * a slice of the accounts into a tally of its own, and the slices are merged in order. The sums are integers, so
+ * the result is the same as that of a pass in name order.
+ */
+bool parallel_vote_tally( const database& d, const global_property_object& props, uint32_t threads,
+                          std::unique_ptr<worker_pool>& pool, vote_tally& tally )
+{
+   const auto& account_idx = d.get_index_type<account_index>().indices().get<by_id>();
+   if( threads == 1 || account_idx.size() < parallel_vote_tally_min_accounts )
+      return false;
+   if( !pool )
+      pool.reset( new worker_pool( threads ) );
+
+   vector<const account_object*> accounts;
+   accounts.reserve( account_idx.size() );
+   for( const account_object& a : account_idx )
+      accounts.push_back( &a );
+
+   const size_t slices = std::min<size_t>( accounts.size(), pool->size() * 4 );
+   vector<vote_tally> partial( slices, vote_tally( props ) );
+   vector<char> fees_pending( slices, 0 );
+   pool->run( slices, [&]( size_t slice ) {
+      const size_t end = accounts.size() * (slice + 1) / slices;
+      for( size_t i = accounts.size() * slice / slices; i < end; ++i )
+      {
+         const auto& stats = accounts[i]->statistics(d);
+         if( stats.pending_fees > 0 || stats.pending_vested_fees > 0 )
+         {
+            fees_pending[slice] = 1;
+            return;
+         }
+         partial[slice].add( d, props, *accounts[i] );
+      }
+   });
+   if( std::find( fees_pending.begin(), fees_pending.end(), 1 ) != fees_pending.end() )
+      return false;
+
+   for( const auto& p : partial )
+      tally.merge( p );
+   return true;
+}
+
 }
 
 void database::perform_chain_maintenance(const signed_block& next_block, const global_property_object& global_props)
@@ -870,69 +999,15 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
 
    struct vote_tally_helper
    {
-      database& d;
+      const database& d;
       const global_property_object& props;
+      vote_tally& tally;
 
-      vote_tally_helper(database& d, const global_property_object& gpo)
-         : d(d), props(gpo)
-      {
-         d._vote_tally_buffer.resize(props.next_available_vote_id);
-         d._witness_count_histogram_buffer.resize(props.parameters.maximum_witness_count / 2 + 1);
-         d._committee_count_histogram_buffer.resize(props.parameters.maximum_committee_count / 2 + 1);
-         d._total_voting_stake = 0;
-      }
-
-      void operator()(const account_object& stake_account) {
-         if( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) )
-         {
-            // There may be a difference between the account whose stake is voting and the one specifying opinions.
-            // Usually they're the same, but if the stake account has specified a voting_account, that account is the one
-            // specifying the opinions.
-            const account_object& opinion_account =
-                  (stake_account.options.voting_account ==
-                   GRAPHENE_PROXY_TO_SELF_ACCOUNT)? stake_account
-                                     : d.get(stake_account.options.voting_account);
-
-            const auto& stats = stake_account.statistics(d);
-            uint64_t voting_stake = stats.total_core_in_orders.value
-                  + (stake_account.cashback_vb.valid() ? (*stake_account.cashback_vb)(d).balance.amount.value: 0)
-                  + d.get_balance(stake_account.get_id(), asset_id_type()).amount.value;
-
-            for( vote_id_type id : opinion_account.options.votes )
-            {
-               uint32_t offset = id.instance();
-               // if they somehow managed to specify an illegal offset, ignore it.
-               if( offset < d._vote_tally_buffer.size() )
-                  d._vote_tally_buffer[offset] += voting_stake;
-            }
-
-            if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
-            {
-               uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
-                                          d._witness_count_histogram_buffer.size() - 1);
-               // votes for a number greater than maximum_witness_count
-               // are turned into votes for maximum_witness_count.
-               //
-               // in particular, this takes care of the case where a
-               // member was voting for a high number, then the
-               // parameter was lowered.
-               d._witness_count_histogram_buffer[offset] += voting_stake;
-            }
-            if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
-            {
-               uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
-                                          d._committee_count_histogram_buffer.size() - 1);
-               // votes for a number greater than maximum_committee_count
-               // are turned into votes for maximum_committee_count.
-               //
-               // same rationale as for witnesses
-               d._committee_count_histogram_buffer[offset] += voting_stake;
-            }
+      vote_tally_helper(const database& d, const global_property_object& gpo, vote_tally& tally)
+         : d(d), props(gpo), tally(tally) {}
 
-            d._total_voting_stake += voting_stake;
-         }
-      }
-   } tally_helper(*this, gpo);
+      void operator()(const account_object& stake_account) { tally.add(d, props, stake_account); }
+   };
 
    struct process_fees_helper
    {
@@ -945,7 +1020,16 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
 
    } fee_helper(*this, gpo);
 
-   perform_helpers<account_index, by_name>(std::tie(tally_helper, fee_helper));
+   vote_tally tally(gpo);
+   if( !parallel_vote_tally(*this, gpo, _maintenance_threads, _maintenance_pool, tally) )
+   {
+      vote_tally_helper tally_helper(*this, gpo, tally);
+      perform_helpers<account_index, by_name>(std::tie(tally_helper, fee_helper));
+   }
+   _vote_tally_buffer = std::move(tally.votes);
+   _witness_count_histogram_buffer = std::move(tally.witness_counts);
+   _committee_count_histogram_buffer = std::move(tally.committee_counts);
+   _total_voting_stake = tally.total_voting_stake;
 
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
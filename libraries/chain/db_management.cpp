@@ -23,6 +23,7 @@
  */
 
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/block_prefetcher.hpp>
 
 #include <graphene/chain/operation_history_object.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
@@ -47,6 +48,18 @@ database::~database()
    clear_pending();
 }
 
+namespace {
+
+/** Sets a flag for as long as it lives, however the scope is left */
+struct scoped_flag
+{
+   scoped_flag( bool& flag, bool value ) : _flag( flag ) { _flag = value; }
+   ~scoped_flag() { _flag = false; }
+   bool& _flag;
+};
+
+}
+
 void database::reindex(fc::path data_dir)
 { try {
    auto last_block = _block_id_to_block.last();
@@ -57,6 +70,12 @@ void database::reindex(fc::path data_dir)
    }
    if( last_block->block_num() <= head_block_num()) return;
 
+   // A pruned block log is not a gap, the blocks after it are fine but the replay can't start below it
+   const uint32_t first_stored_block = _block_id_to_block.first_block_num();
+   FC_ASSERT( head_block_num() + 1 >= first_stored_block,
+              "The block log was pruned below block ${first}, it can't replay onto state at block ${head}",
+              ("first", first_stored_block)("head", head_block_num()) );
+
    ilog( "reindexing blockchain" );
    auto start = fc::time_point::now();
    const auto last_block_num = last_block->block_num();
@@ -71,6 +90,31 @@ void database::reindex(fc::path data_dir)
    }
    else
       _undo_db.disable();
+
+   uint32_t skip = skip_transaction_dupe_check |
+                   skip_tapos_check |
+                   skip_witness_schedule_check;
+   if( _replay_verify_signatures )
+      ilog( "Verifying the witness and transaction signatures of the replayed blocks" );
+   else
+      skip |= skip_witness_signature | skip_transaction_signatures | skip_authority_check;
+   scoped_flag verify_transactions( _verify_block_transaction_signatures, _replay_verify_signatures );
+   scoped_flag reindexing( _reindexing, true );
+   if( _replay_profile_dump )
+      _block_profiler.set_enabled( true );
+   // the blocks applied without undo history are not journaled one by one, the state is flushed once they are
+   // applied and the journal starts over from there
+   if( journal_enabled() && head_block_num() + 1 < undo_point )
+      set_journal_suspended( true );
+
+   // Blocks below undo_point are applied without storing anything in the block log, so until then another thread
+   // can read and hash them ahead of the one applying them, and recover the keys of their signatures.
+   std::unique_ptr<block_prefetcher> prefetcher;
+   if( _reindex_prefetch_blocks > 0 && head_block_num() + 1 < undo_point )
+      prefetcher.reset( new block_prefetcher( _block_id_to_block, head_block_num() + 1, undo_point - 1,
+                                              _reindex_prefetch_blocks, true,
+                                              _replay_verify_signatures ? get_chain_id()
+                                                                        : optional<chain_id_type>() ) );
    for( uint32_t i = head_block_num() + 1; i <= last_block_num; ++i )
    {
       if( i % 10000 == 0 ) std::cerr << "   " << double(i*100)/last_block_num << "%   "<<i << " of " <<last_block_num<<"   \n";
@@ -80,9 +124,26 @@ void database::reindex(fc::path data_dir)
          flush();
          ilog( "Done" );
       }
-      fc::optional< signed_block > block = _block_id_to_block.fetch_by_number(i);
+      fc::optional< signed_block > block;
+      fc::optional< block_digests > digests;
+      if( prefetcher && i < undo_point )
+      {
+         fc::optional< prefetched_block > prefetched = prefetcher->next();
+         if( prefetched.valid() )
+         {
+            block = std::move( prefetched->block );
+            digests = std::move( prefetched->digests );
+         }
+      }
+      else
+      {
+         // push_block() stores blocks from here on
+         prefetcher.reset();
+         block = _block_id_to_block.fetch_by_number(i);
+      }
       if( !block.valid() )
       {
+         prefetcher.reset();
          wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
          uint32_t dropped_count = 0;
          while( true )
@@ -104,24 +165,24 @@ void database::reindex(fc::path data_dir)
          break;
       }
       if( i < undo_point )
-         apply_block(*block, skip_witness_signature |
-                             skip_transaction_signatures |
-                             skip_transaction_dupe_check |
-                             skip_tapos_check |
-                             skip_witness_schedule_check |
-                             skip_authority_check);
+      {
+         if( digests.valid() )
+            apply_block(*block, skip, *digests);
+         else
+            apply_block(*block, skip);
+      }
       else
       {
          _undo_db.enable();
-         push_block(*block, skip_witness_signature |
-                            skip_transaction_signatures |
-                            skip_transaction_dupe_check |
-                            skip_tapos_check |
-                            skip_witness_schedule_check |
-                            skip_authority_check);
+         set_journal_suspended( false );
+         push_block(*block, skip);
       }
+      if( _replay_profile_dump )
+         ilog( "Block profile: ${p}", ("p", _block_profiler.get_last_block()) );
    }
    _undo_db.enable();
+   set_journal_suspended( false );
+   prune_block_log();
    auto end = fc::time_point::now();
    ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
@@ -142,6 +203,7 @@ void database::open(
 {
    try
    {
+      _db_version = db_version;
       bool wipe_object_db = false;
       if( !fc::exists( data_dir / "db_version" ) )
          wipe_object_db = true;
@@ -162,7 +224,7 @@ void database::open(
 
       object_database::open(data_dir);
 
-      _block_id_to_block.open(data_dir / "database" / "block_num_to_block");
+      _block_id_to_block.open(data_dir / "database" / "block_num_to_block", _block_database_options);
 
       if( !find(global_property_id_type()) )
          init_genesis(genesis_loader());
@@ -175,6 +237,8 @@ void database::open(
                     ("last_block->id", last_block)("head_block_id",head_block_num()) );
          reindex( data_dir );
       }
+      verify_imported_snapshot();
+      _journal_checkpoint_block = get_dynamic_global_properties().last_irreversible_block_num;
    }
    FC_CAPTURE_LOG_AND_RETHROW( (data_dir) )
 }
@@ -0,0 +1,212 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/snapshot.hpp>
+
+#include <fc/interprocess/file_mapping.hpp>
+#include <fc/io/raw.hpp>
+
+#include <fstream>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   /** Writes to a file and hashes everything written, fc::raw::pack can write into it directly */
+   struct checksummed_writer
+   {
+      explicit checksummed_writer( std::ofstream& out ):out(out){}
+
+      void write( const char* data, size_t size )
+      {
+         out.write( data, size );
+         enc.write( data, size );
+      }
+      void put( char c ) { write( &c, 1 ); }
+
+      std::ofstream&      out;
+      fc::sha256::encoder enc;
+   };
+
+}
+
+void database::create_snapshot( const fc::path& snapshot_file )
+{ try {
+   // Blocks after the last irreversible one may still be switched away from, so the snapshot is taken of the state
+   // before their undo states
+   clear_pending();
+   const uint32_t reversible_blocks = head_block_num() - get_dynamic_global_properties().last_irreversible_block_num;
+   with_undo_states_rewound( reversible_blocks, [&]() {
+      snapshot_header header;
+      header.db_version = _db_version;
+      header.chain_id = get_chain_id();
+      header.head_block_num = head_block_num();
+      header.head_block_id = head_block_id();
+      header.head_block_time = head_block_time();
+      header.state_hash = get_state_hash();
+
+      // a node loading the snapshot needs these to tell its peers where it is
+      vector<signed_block> blocks;
+      for( uint32_t num = std::max( get_dynamic_global_properties().last_irreversible_block_num, 1u ); num <= head_block_num(); ++num )
+      {
+         auto block = fetch_block_by_number( num );
+         FC_ASSERT( block.valid(), "Block ${n} is missing, the snapshot needs it", ("n", num) );
+         blocks.push_back( std::move( *block ) );
+      }
+
+      const fc::path index_dir = snapshot_file.generic_string() + ".indices";
+      const fc::path tmp_file = snapshot_file.generic_string() + ".tmp";
+      fc::remove_all( index_dir );
+      const auto ids = save_indices( index_dir );
+
+      {
+         std::ofstream out( tmp_file.generic_string(), std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+         FC_ASSERT( out, "Unable to create ${f}", ("f", tmp_file) );
+         checksummed_writer writer( out );
+         fc::raw::pack( writer, snapshot_magic );
+         fc::raw::pack( writer, header );
+         fc::raw::pack( writer, blocks );
+         fc::raw::pack( writer, uint32_t( ids.size() ) );
+
+         vector<char> buffer( 1 << 20 );
+         for( const auto& id : ids )
+         {
+            const fc::path file = index_dir / fc::to_string(id.first) / fc::to_string(id.second);
+            const uint64_t size = fc::file_size( file );
+            fc::raw::pack( writer, id.first );
+            fc::raw::pack( writer, id.second );
+            fc::raw::pack( writer, size );
+            std::ifstream in( file.generic_string(), std::ifstream::binary );
+            for( uint64_t copied = 0; copied < size; )
+            {
+               const size_t chunk = std::min<uint64_t>( buffer.size(), size - copied );
+               in.read( buffer.data(), chunk );
+               FC_ASSERT( in, "Failed to read ${f}", ("f", file) );
+               writer.write( buffer.data(), chunk );
+               copied += chunk;
+            }
+         }
+
+         const fc::sha256 checksum = writer.enc.result();
+         out.write( checksum.data(), checksum.data_size() );
+         out.flush();
+         FC_ASSERT( out, "Failed to write ${f}", ("f", tmp_file) );
+      }
+      fc::remove_all( index_dir );
+      fc::rename( tmp_file, snapshot_file );
+      ilog( "Wrote snapshot of block ${n} to ${f}", ("n", header.head_block_num)("f", snapshot_file) );
+   });
+} FC_CAPTURE_AND_RETHROW( (snapshot_file) ) }
+
+bool database::import_snapshot( const fc::path& snapshot_file, const fc::path& data_dir, const std::string& db_version )
+{ try {
+   FC_ASSERT( !_block_id_to_block.is_open(), "A snapshot must be imported before the database is opened" );
+   // a snapshot option left in place must not replace the state a node has built since it was imported
+   if( fc::exists( data_dir / "object_database" ) || fc::exists( data_dir / "database" ) )
+   {
+      wlog( "Not importing snapshot ${f}, ${d} already holds chain state", ("f", snapshot_file)("d", data_dir) );
+      return false;
+   }
+
+   fc::file_mapping fm( snapshot_file.generic_string().c_str(), fc::read_only );
+   fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size( snapshot_file ) );
+   const char* begin = (const char*)mr.get_address();
+   fc::sha256 checksum;
+   FC_ASSERT( mr.get_size() > checksum.data_size(), "Snapshot ${f} is too short", ("f", snapshot_file) );
+   const size_t payload_size = mr.get_size() - checksum.data_size();
+   memcpy( checksum.data(), begin + payload_size, checksum.data_size() );
+   fc::sha256::encoder enc;
+   for( size_t hashed = 0; hashed < payload_size; )
+   {
+      const uint32_t chunk = std::min<size_t>( payload_size - hashed, 1 << 30 );
+      enc.write( begin + hashed, chunk );
+      hashed += chunk;
+   }
+   FC_ASSERT( enc.result() == checksum, "Snapshot ${f} is corrupt, its checksum does not match", ("f", snapshot_file) );
+
+   fc::datastream<const char*> ds( begin, payload_size );
+   uint64_t magic = 0;
+   fc::raw::unpack( ds, magic );
+   FC_ASSERT( magic == snapshot_magic, "${f} is not a snapshot", ("f", snapshot_file) );
+   snapshot_header header;
+   fc::raw::unpack( ds, header );
+   FC_ASSERT( header.format == snapshot_format, "Unknown snapshot format ${v}", ("v", header.format) );
+   FC_ASSERT( header.db_version == db_version, "Snapshot was taken with database version ${s}, this node uses ${v}",
+              ("s", header.db_version)("v", db_version) );
+   vector<signed_block> blocks;
+   fc::raw::unpack( ds, blocks );
+   uint32_t index_count = 0;
+   fc::raw::unpack( ds, index_count );
+
+   ilog( "Importing snapshot of block ${n} from ${f}", ("n", header.head_block_num)("f", snapshot_file) );
+   fc::remove_all( data_dir / "object_database.journal" );
+   for( uint32_t i = 0; i < index_count; ++i )
+   {
+      uint8_t space = 0;
+      uint8_t type = 0;
+      uint64_t size = 0;
+      fc::raw::unpack( ds, space );
+      fc::raw::unpack( ds, type );
+      fc::raw::unpack( ds, size );
+      FC_ASSERT( ds.remaining() >= size, "Snapshot ${f} is truncated", ("f", snapshot_file) );
+      const fc::path dir = data_dir / "object_database" / fc::to_string(space);
+      fc::create_directories( dir );
+      std::ofstream out( (dir / fc::to_string(type)).generic_string(), std::ofstream::binary | std::ofstream::trunc );
+      out.write( ds.pos(), size );
+      FC_ASSERT( out, "Failed to write index ${s}.${t}", ("s", space)("t", type) );
+      ds.skip( size );
+   }
+
+   {
+      block_database block_db;
+      block_db.open( data_dir / "database" / "block_num_to_block", _block_database_options );
+      for( const auto& block : blocks )
+         block_db.store( block.id(), block );
+      block_db.close();
+   }
+
+   std::ofstream version_file( (data_dir / "db_version").generic_string().c_str(),
+                               std::ios::out | std::ios::binary | std::ios::trunc );
+   version_file.write( db_version.c_str(), db_version.size() );
+   version_file.close();
+
+   _imported_snapshot = header;
+   return true;
+} FC_CAPTURE_AND_RETHROW( (snapshot_file)(data_dir) ) }
+
+void database::verify_imported_snapshot()
+{
+   if( !_imported_snapshot.valid() )
+      return;
+   const snapshot_header header = *_imported_snapshot;
+   _imported_snapshot.reset();
+   FC_ASSERT( get_chain_id() == header.chain_id && head_block_id() == header.head_block_id,
+              "State loaded from the snapshot is not at block ${n} of chain ${c}",
+              ("n", header.head_block_num)("c", header.chain_id) );
+   FC_ASSERT( get_state_hash() == header.state_hash, "State loaded from the snapshot does not match its state hash" );
+   ilog( "Resuming from snapshot at block ${n}", ("n", header.head_block_num) );
+}
+
+} }
@@ -42,7 +42,7 @@
 
 namespace graphene { namespace chain {
 
-void database::update_global_dynamic_data( const signed_block& b )
+void database::update_global_dynamic_data( const signed_block& b, const block_id_type& b_id )
 {
    const dynamic_global_property_object& _dgp =
       dynamic_global_property_id_type(0)(*this);
@@ -79,7 +79,7 @@ void database::update_global_dynamic_data( const signed_block& b )
          dgp.recently_missed_count--;
 
       dgp.head_block_number = b.block_num();
-      dgp.head_block_id = b.id();
+      dgp.head_block_id = b_id;
       dgp.time = b.timestamp;
       dgp.current_witness = b.witness;
       dgp.recent_slots_filled = (
@@ -158,6 +158,17 @@ void database::update_last_irreversible_block()
    }
 }
 
+void database::prune_block_log()
+{
+   const uint32_t retain_blocks = _block_database_options.retain_blocks;
+   const dynamic_global_property_object& dpo = get_dynamic_global_properties();
+   if( retain_blocks == 0 || dpo.head_block_number < retain_blocks )
+      return;
+
+   // Blocks from the last irreversible one onwards may still be needed to switch forks or to sync peers
+   _block_id_to_block.prune( std::min( dpo.head_block_number - retain_blocks + 1, dpo.last_irreversible_block_num ) );
+}
+
 void database::clear_expired_transactions()
 { try {
    //Look for expired transactions in the deduplication list, and remove them.
@@ -510,20 +521,7 @@ void database::reset_spending_limits()
 
   if ( dgpo.next_spend_limit_reset <= head_block_time() )
   {
-    // Reset spending limit for each account:
-    const auto& account_idx = get_index_type<account_index>().indices().get<by_id>();
-    for ( const auto& account : account_idx )
-    {
-      // TODO: price should be a weekly average price, not the last price at the moment of sampling.
-      auto dsc_limit = get_dascoin_limit(account, dgpo.last_dascoin_price);
-      if ( dsc_limit.valid() )
-      {
-        // Set the limit on the account balance object:
-        adjust_balance_limit(account, get_dascoin_asset_id(), *dsc_limit, true);
-      }
-    }
-
-    // Set the time of the next limit reset:
+    // Set the time of the next limit reset, and the price all the limits of this one are computed from:
     modify(dgpo, [&](dynamic_global_property_object& dgpo){
       dgpo.last_daily_dascoin_price = dgpo.last_dascoin_price;
       uint32_t now_sec = head_block_time().sec_since_epoch();
@@ -534,9 +532,43 @@ void database::reset_spending_limits()
         dgpo.next_spend_limit_reset = fc::time_point_sec(next_interval) + params.limit_interval_elapse_time_seconds;
       else
         dgpo.next_spend_limit_reset = fc::time_point_sec(next_interval);
+      // Start with the first vault, a reset that is still spread over blocks starts over:
+      dgpo.next_spend_limit_reset_account = account_id_type();
     });
   }
 
+  if ( !dgpo.next_spend_limit_reset_account.valid() )
+    return;
+
+  // 0 resets all the vaults in one block:
+  uint32_t accounts_per_block = 0;
+  for ( const auto& ext : params.extensions )
+    if ( ext.which() == chain_parameters::chain_parameters_extension::tag< spending_limit_reset_batch_type >::value )
+      accounts_per_block = ext.get<spending_limit_reset_batch_type>().accounts_per_block;
+
+  // Only vaults have a spending limit, so walk them in id order instead of all accounts:
+  const auto& vault_idx = get_index_type<account_index>().indices().get<by_kind>();
+  auto itr = vault_idx.lower_bound(boost::make_tuple(account_kind::vault,
+                                                     object_id_type(*dgpo.next_spend_limit_reset_account)));
+  const auto end = vault_idx.upper_bound(boost::make_tuple(account_kind::vault));
+  for ( uint32_t reset = 0; itr != end && (accounts_per_block == 0 || reset < accounts_per_block); ++itr, ++reset )
+  {
+    // TODO: price should be a weekly average price, not the last price at the moment of sampling.
+    auto dsc_limit = get_dascoin_limit(*itr, dgpo.last_daily_dascoin_price);
+    if ( dsc_limit.valid() )
+    {
+      // Set the limit on the account balance object:
+      adjust_balance_limit(*itr, get_dascoin_asset_id(), *dsc_limit, true);
+    }
+  }
+
+  modify(dgpo, [&](dynamic_global_property_object& dgpo){
+    if ( itr == end )
+      dgpo.next_spend_limit_reset_account.reset();
+    else
+      dgpo.next_spend_limit_reset_account = itr->get_id();
+  });
+
 } FC_CAPTURE_AND_RETHROW() }
 
 void database::mint_dascoin_rewards()
@@ -726,18 +758,30 @@ void database::resolve_delayed_operations()
   if ( dgpo.next_delayed_operations_resolver_time > head_block_time() )
     return;
 
-  const auto& idx = get_index_type<delayed_operations_index>().indices().get<by_account>();
-  for (auto it = idx.cbegin(); it != idx.cend(); ++it)
+  // 0 resolves all the due operations in one block:
+  uint32_t operations_per_block = 0;
+  for ( const auto& ext : params.parameters.extensions )
+    if ( ext.which() == chain_parameters::chain_parameters_extension::tag< delayed_operations_resolver_batch_type >::value )
+      operations_per_block = ext.get<delayed_operations_resolver_batch_type>().operations_per_block;
+
+  // Due operations are at the front of the index, so stop at the first one that is not due yet:
+  const auto& idx = get_index_type<delayed_operations_index>().indices().get<by_due_time>();
+  uint32_t resolved = 0;
+  for ( auto it = idx.begin(); it != idx.end() && it->due_time() <= head_block_time(); )
   {
-    if (it->issued_time + it->skip <= head_block_time())
-    {
-      it->op.visit(op_visitor(*this));
-      remove(*it);
-    }
+    if ( operations_per_block != 0 && resolved == operations_per_block )
+      break;
+    const auto& delayed_op = *it++;
+    delayed_op.op.visit(op_visitor(*this));
+    remove(delayed_op);
+    ++resolved;
   }
 
+  // Operations left over by the cap are resolved in the next block:
+  const bool pending = !idx.empty() && idx.begin()->due_time() <= head_block_time();
   modify(dgpo, [&](dynamic_global_property_object& dgpo){
-    dgpo.next_delayed_operations_resolver_time = head_block_time() + params.delayed_operations_resolver_interval_time_seconds;
+    dgpo.next_delayed_operations_resolver_time = pending ? head_block_time()
+                                                         : head_block_time() + params.delayed_operations_resolver_interval_time_seconds;
   });
 
 } FC_CAPTURE_AND_RETHROW() }
@@ -45,9 +45,18 @@ database& generic_evaluator::db()const { return trx_state->db(); }
    { try {
       trx_state   = &eval_state;
       //check_required_authorities(op);
-      auto result = evaluate( op );
+      block_profiler& profiler = db().get_block_profiler();
+      operation_result result;
+      {
+         block_profiler::scoped_operation timer( profiler, get_type(), false );
+         result = evaluate( op );
+      }
 
-      if( apply ) result = this->apply( op );
+      if( apply )
+      {
+         block_profiler::scoped_operation timer( profiler, get_type(), true );
+         result = this->apply( op );
+      }
       return result;
    } FC_CAPTURE_AND_RETHROW() }
 
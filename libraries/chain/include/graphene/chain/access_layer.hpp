@@ -246,6 +246,17 @@ struct signed_block_with_num
     : num(num), block_id(block_id), block(block) {}
 };
 
+struct packed_block_with_num
+{
+  uint32_t num;
+  block_id_type block_id;
+  vector<char> packed_block;
+
+  packed_block_with_num() = default;
+  explicit packed_block_with_num(uint32_t num, block_id_type block_id, vector<char>&& packed_block)
+    : num(num), block_id(block_id), packed_block(std::move(packed_block)) {}
+};
+
 struct signed_block_with_virtual_operations_and_num
 {
   uint32_t num;
@@ -273,6 +284,7 @@ class database_access_layer {
     // Transactions and blocks:
     // TODO: expose get_block through this interface.
     vector<signed_block_with_num> get_blocks(uint32_t start_block_num, uint32_t count) const;
+    vector<packed_block_with_num> get_blocks_raw(uint32_t start_block_num, uint32_t count) const;
     vector<signed_block_with_virtual_operations_and_num> get_blocks_with_virtual_operations(uint32_t start_block_num,
                                                                                             uint32_t count,
                                                                                             std::vector<uint16_t>& virtual_operation_ids) const;
@@ -354,6 +366,7 @@ class database_access_layer {
         return vector<typename IndexType::object_type>(idx.begin(), idx.end());
     }
 
+    // IndexBy must be a ranked index, the page is found with nth() in O(log n).
     template <typename IndexType, typename IndexBy, int MAX_ELEMENTS = 100>
     vector<typename IndexType::object_type> get_range(uint32_t from, uint32_t amount) const
     {
@@ -361,10 +374,8 @@ class database_access_layer {
         FC_ASSERT(idx.size() > from, "Index out of bounds, index: ${from}, size: ${size}", ("from", from)("size", idx.size()));
         FC_ASSERT(idx.size() - from >= amount, "Index out of bounds, amount: ${amount}, size: ${size}", ("amount", amount)("size", idx.size()));
         FC_ASSERT(amount <= MAX_ELEMENTS, "Cannot retrieve more than ${max} elements in one page", ("max", MAX_ELEMENTS));
-        auto start = idx.begin();
-        std::advance(start, from);
-        auto end = idx.begin();
-        std::advance(end, from + amount);
+        auto start = idx.nth(from);
+        auto end = idx.nth(from + amount);
         return vector<typename IndexType::object_type>(start, end);
     }
 
@@ -395,6 +406,7 @@ FC_REFLECT(graphene::chain::sub_w_pos, (position)(submission))
 FC_REFLECT_DERIVED(graphene::chain::acc_id_queue_subs_w_pos_res, (graphene::chain::acc_id_res), (result))
 
 FC_REFLECT( graphene::chain::signed_block_with_num, (num)(block_id)(block) )
+FC_REFLECT( graphene::chain::packed_block_with_num, (num)(block_id)(packed_block) )
 FC_REFLECT( graphene::chain::signed_block_with_virtual_operations_and_num, (num)(block_id)(block) )
 
 FC_REFLECT(graphene::chain::vault_info_res,
@@ -25,7 +25,7 @@
 #include <graphene/chain/protocol/operations.hpp>
 #include <graphene/chain/license_objects.hpp>
 #include <graphene/chain/upgrade_type.hpp>
-#include <graphene/db/generic_index.hpp>
+#include <graphene/db/dense_index.hpp>
 #include <boost/multi_index/composite_key.hpp>
 
 namespace graphene { namespace chain {
@@ -503,9 +503,10 @@ namespace graphene { namespace chain {
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
+   typedef dense_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
 
    struct by_name;
+   struct by_kind;
    typedef multi_index_container<
       account_object,
       indexed_by<
@@ -514,6 +515,12 @@ namespace graphene { namespace chain {
          >,
          ordered_unique< tag<by_name>,
             member<account_object, string, &account_object::name>
+         >,
+         ordered_unique< tag<by_kind>,
+            composite_key< account_object,
+               member<account_object, account_kind, &account_object::kind>,
+               member<object, object_id_type, &object::id>
+            >
          >
       >
    > account_multi_index_type;
@@ -521,7 +528,7 @@ namespace graphene { namespace chain {
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_object, account_multi_index_type> account_index;
+   typedef dense_index<account_object, account_multi_index_type> account_index;
 
    struct by_account_id;
    typedef multi_index_container<
@@ -536,7 +543,7 @@ namespace graphene { namespace chain {
       >
    > account_cycle_balance_multi_index_type;
 
-   typedef generic_index<
+   typedef dense_index<
       account_cycle_balance_object, account_cycle_balance_multi_index_type
    > account_cycle_balance_index;
 
@@ -565,7 +572,7 @@ namespace graphene { namespace chain {
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_statistics_object, account_stats_multi_index_type> account_stats_index;
+   typedef dense_index<account_statistics_object, account_stats_multi_index_type> account_stats_index;
 
 } }  // namsepace graphene::chain
 
@@ -23,19 +23,66 @@
  */
 #pragma once
 #include <fstream>
+#include <memory>
 #include <graphene/chain/protocol/block.hpp>
 
 namespace graphene { namespace chain {
    struct index_entry;
+   class segmented_block_log;
+   namespace detail { class mapped_file; }
 
+   /**
+    * Storage options for block_database. The defaults reproduce the original layout: a single
+    * index file and a single blocks file, both read through std::fstream.
+    */
+   struct block_database_options
+   {
+      /**
+       * Serve reads from read-only memory maps of the index and blocks files. Readers only use
+       * offsets into the mapping and never touch the shared streams, so any number of threads may
+       * fetch blocks while the chain thread appends new ones.
+       */
+      bool memory_mapped = false;
+
+      /**
+       * Store blocks in a segmented_block_log under the segments directory instead of the single blocks
+       * file. Blocks from an existing single-file layout are moved into segments on open. Reads in this
+       * layout always go through memory maps.
+       */
+      bool     segmented = false;
+      /** Block numbers per segment, must not change once segments were written */
+      uint32_t blocks_per_segment = 100000;
+      /** zlib-compress every block in the segmented layout */
+      bool     compress = true;
+      /**
+       * If not 0, the database prunes blocks older than the most recent retain_blocks, but never the last
+       * irreversible block. Requires the segmented layout.
+       */
+      uint32_t retain_blocks = 0;
+   };
+
+   /**
+    * @class block_database
+    * @brief Stores the irreversible (and recently applied) blocks on disk, addressed by block number
+    *
+    * Only one thread may write (store, remove, last, last_id). With
+    * block_database_options::memory_mapped or segmented set, the contains() and fetch_* methods
+    * may additionally be called from any number of other threads. A fetch that races a rewrite of
+    * the same block's index entry finds nothing rather than a mix of both entries.
+    */
    class block_database
    {
       public:
-         void open( const fc::path& dbdir );
+         block_database();
+         ~block_database();
+
+         void open( const fc::path& dbdir, const block_database_options& options = block_database_options() );
          bool is_open()const;
          void flush();
          void close();
 
+         const block_database_options& get_options()const { return _options; }
+
          void store( const block_id_type& id, const signed_block& b );
          void remove( const block_id_type& id );
 
@@ -43,12 +90,57 @@ namespace graphene { namespace chain {
          block_id_type          fetch_block_id( uint32_t block_num )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /**
+          * @return the packed signed_block exactly as stored, without unpacking it, or nothing if
+          * there is no block at block_num. The bytes are not hashed, so the caller trusts the index.
+          */
+         optional<vector<char>> fetch_raw( uint32_t block_num )const;
+         /** Same as fetch_raw(), but only returns the block if its id matches */
+         optional<vector<char>> fetch_raw_optional( const block_id_type& id )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
+
+         /** @return the lowest block number that may still be stored, 1 unless the log was pruned */
+         uint32_t first_block_num()const;
+         /**
+          * Deletes stored blocks below first_kept_block, as far as the layout allows. The single-file
+          * layout can't be pruned and is left alone.
+          */
+         void prune( uint32_t first_kept_block );
       private:
          optional<index_entry> last_index_entry()const;
+
+         /** @return false if the index holds no entry for block_num */
+         bool read_index_entry( uint32_t block_num, index_entry& e )const;
+         /** Reads the packed block described by e into data, throws if the blocks file is too short */
+         void read_block_data( const index_entry& e, vector<char>& data )const;
+         /**
+          * Reads the id and packed bytes stored for block_num in whichever layout is open, data is left
+          * empty for a removed block. A memory mapped index entry is read again after the data and has
+          * to be unchanged, store() and remove() may be rewriting it meanwhile.
+          * @return false if there is no entry for block_num
+          */
+         bool read_stored_block( uint32_t block_num, block_id_type& id, vector<char>& data )const;
+         /**
+          * Like read_stored_block(), for the fetches that return the bytes without unpacking the block.
+          * The header in data has to hash to the stored id, which catches an entry read while it was torn.
+          */
+         bool read_raw_block( uint32_t block_num, block_id_type& id, vector<char>& data )const;
+         /**
+          * Moves the blocks of the single-file layout into segments under import_dir, then renames the index to
+          * imported_index, import_dir to segments_dir and deletes the old files. open() completes or discards an
+          * import that was interrupted at any of these steps.
+          */
+         void import_into_segments( const fc::path& segments_dir, const fc::path& import_dir,
+                                    const fc::path& imported_index );
+
+         block_database_options _options;
          fc::path _index_filename;
+         fc::path _blocks_filename;
          mutable std::fstream _blocks;
          mutable std::fstream _block_num_to_pos;
+         std::unique_ptr<detail::mapped_file> _mapped_index;
+         std::unique_ptr<detail::mapped_file> _mapped_blocks;
+         std::unique_ptr<segmented_block_log> _segments;
    };
 } }
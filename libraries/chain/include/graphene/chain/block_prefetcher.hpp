@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+#include <graphene/chain/protocol/block.hpp>
+#include <graphene/db/worker_pool.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+
+namespace graphene { namespace chain {
+
+   class block_database;
+
+   /** A block read back from the block log, with the digests the chain would otherwise compute while applying it */
+   struct prefetched_block
+   {
+      signed_block  block;
+      block_digests digests;
+   };
+
+   /**
+    * @class block_prefetcher
+    * @brief Reads, unpacks and hashes the blocks of a replay on a thread of its own
+    *
+    * Blocks first to last are fetched in order into a queue of at most capacity blocks, so the thread applying them
+    * only waits for the block log when it overtakes the reader. The reader stops at the first missing block.
+    *
+    * Given a chain id, the reader also recovers the keys of the witness and transaction signatures on a worker_pool
+    * of its own, a batch of blocks at a time. Checking the signatures while applying the blocks then finds the keys
+    * in the signature_cache and the transactions' precomputed keys.
+    *
+    * The block_database must not be written to while the prefetcher reads from it, unless its options allow
+    * concurrent fetches. Destroying the prefetcher stops the reader.
+    */
+   class block_prefetcher
+   {
+      public:
+         block_prefetcher( const block_database& blocks, uint32_t first, uint32_t last, size_t capacity,
+                           bool with_merkle_roots = true,
+                           const optional<chain_id_type>& signature_chain_id = optional<chain_id_type>() );
+         ~block_prefetcher();
+
+         /**
+          * Waits for the next block in [first, last]. Must not be called again once block last was returned.
+          * @return the block, or nothing if it is missing from the block log
+          * @throws whatever reading the block threw
+          */
+         optional<prefetched_block> next();
+
+      private:
+         void read_blocks();
+         optional<prefetched_block> read_block( uint32_t num )const;
+         void recover_signature_keys( const vector<optional<prefetched_block>>& batch );
+         /** @return false if the reader was told to stop while it waited for room in the queue */
+         bool push( optional<prefetched_block>&& item );
+
+         const block_database&  _blocks;
+         const uint32_t         _first;
+         const uint32_t         _last;
+         const size_t           _capacity;
+         const bool             _with_merkle_roots;
+         /** number of the block next() returns next */
+         uint32_t               _next;
+
+         optional<chain_id_type>                     _signature_chain_id;
+         std::unique_ptr<graphene::db::worker_pool>  _signature_pool;
+
+         std::mutex                             _mutex;
+         std::condition_variable                _not_full;
+         std::condition_variable                _not_empty;
+         std::deque<optional<prefetched_block>> _queue;
+         /** set by the reader once it stopped, guarded by _mutex */
+         bool                                   _done = false;
+         /** set to make the reader stop early, guarded by _mutex */
+         bool                                   _stop = false;
+         /** what stopped the reader, if it did not stop normally */
+         std::exception_ptr                     _error;
+
+         fc::thread                             _thread;
+         fc::future<void>                       _reader;
+   };
+
+} } // graphene::chain
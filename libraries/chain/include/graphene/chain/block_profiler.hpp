@@ -0,0 +1,239 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+#include <fc/reflect/reflect.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /** The parts of database::_apply_block that are timed separately */
+   enum block_phase
+   {
+      phase_header,                  ///< merkle root and block header checks
+      phase_transactions,            ///< the block's transactions, including their operations' evaluators
+      phase_global_dynamic_data,     ///< dynamic global properties, signing witness, last irreversible block
+      phase_maintenance,             ///< the maintenance interval, on the blocks that start one
+      phase_clear_expired,           ///< block summary and expired transactions, proposals, orders and feeds
+      phase_witness_schedule,
+      phase_reset_spending_limits,
+      phase_mint_dascoin_rewards,
+      phase_daspay_clearing,
+      phase_delayed_operations,
+      phase_notify,                  ///< debug updates and the applied block and changed objects signals
+      phase_count
+   };
+
+   /**
+    * Durations in nanoseconds, bucketed by powers of two of microseconds: bucket 0 counts durations below 1us,
+    * bucket i those from 2^(i-1)us up to 2^i us and the last bucket everything longer.
+    */
+   struct timing_histogram
+   {
+      static const size_t bucket_count = 24;
+
+      uint64_t              count = 0;
+      uint64_t              total_ns = 0;
+      uint64_t              max_ns = 0;
+      std::vector<uint64_t> buckets;
+
+      void add( uint64_t ns );
+      void merge( const timing_histogram& other );
+   };
+
+   /** The phases and operations of one block, in microseconds */
+   struct block_profile
+   {
+      uint32_t                          block_num = 0;
+      uint64_t                          total_us = 0;
+      std::map<std::string, uint64_t>   phases;
+      /** time spent evaluating and applying operations, keyed by operation name */
+      std::map<std::string, uint64_t>   operations;
+   };
+
+   /** Histograms over the recently applied blocks */
+   struct block_profile_stats
+   {
+      /** number of blocks the histograms cover, between one and two windows */
+      uint32_t                                  blocks = 0;
+      uint32_t                                  window_blocks = 0;
+      timing_histogram                          total;
+      std::map<std::string, timing_histogram>   phases;
+      /** evaluator timings keyed by operation name */
+      std::map<std::string, timing_histogram>   evaluate;
+      std::map<std::string, timing_histogram>   apply;
+   };
+
+   /**
+    * @class block_profiler
+    * @brief Times the phases of applying a block and the evaluators of its operations
+    *
+    * The chain thread records the timings of a block with scoped_phase and scoped_operation between begin_block()
+    * and end_block(), which folds them into the histograms of the current window. A block that throws is discarded
+    * with abort_block(), scoped_block does either on every path out of its scope. Once the current window spans
+    * window_blocks blocks it replaces the previous one, so get_stats() covers between one and two windows of the most
+    * recent blocks. Operations evaluated outside of a block, like pending transactions, are not timed.
+    *
+    * A disabled profiler reads no clocks.
+    */
+   class block_profiler
+   {
+      public:
+         typedef std::chrono::steady_clock clock;
+         static const uint32_t default_window_blocks = 1000;
+
+         block_profiler();
+
+         void set_enabled( bool enabled ) { _enabled = enabled; }
+         bool enabled()const { return _enabled; }
+         /** Sets the number of blocks per window and clears the histograms */
+         void set_window_blocks( uint32_t blocks );
+
+         void begin_block();
+         void end_block( uint32_t block_num );
+         /** Discards the timings of a block that failed to apply */
+         void abort_block();
+
+         /** @return whether timings are recorded right now */
+         bool recording()const { return _enabled && _in_block; }
+
+         block_profile       get_last_block()const;
+         block_profile_stats get_stats()const;
+
+         /** Begins a block for the scope, which aborts it unless end() records it first */
+         class scoped_block
+         {
+            public:
+               explicit scoped_block( block_profiler& profiler ) : _profiler( profiler ) { _profiler.begin_block(); }
+               ~scoped_block()
+               {
+                  if( !_ended )
+                     _profiler.abort_block();
+               }
+               void end( uint32_t block_num )
+               {
+                  _ended = true;
+                  _profiler.end_block( block_num );
+               }
+            private:
+               block_profiler&    _profiler;
+               bool               _ended = false;
+         };
+
+         /** Times the scope as a phase of the block being applied */
+         class scoped_phase
+         {
+            public:
+               scoped_phase( block_profiler& profiler, block_phase phase )
+                  : _profiler( profiler ), _phase( phase ), _timing( profiler.recording() )
+               {
+                  if( _timing )
+                     _start = clock::now();
+               }
+               ~scoped_phase()
+               {
+                  if( _timing )
+                     _profiler._block_phases[_phase] += elapsed_ns( _start );
+               }
+            private:
+               block_profiler&    _profiler;
+               block_phase        _phase;
+               bool               _timing;
+               clock::time_point  _start;
+         };
+
+         /** Times the scope as the evaluation or the application of an operation of the block being applied */
+         class scoped_operation
+         {
+            public:
+               scoped_operation( block_profiler& profiler, int operation_type, bool apply )
+                  : _profiler( profiler ), _operation_type( operation_type ), _apply( apply ),
+                    _timing( profiler.recording() )
+               {
+                  if( _timing )
+                     _start = clock::now();
+               }
+               ~scoped_operation()
+               {
+                  if( _timing )
+                     ( _apply ? _profiler._block_apply : _profiler._block_evaluate )
+                        .emplace_back( _operation_type, elapsed_ns( _start ) );
+               }
+            private:
+               block_profiler&    _profiler;
+               int                _operation_type;
+               bool               _apply;
+               bool               _timing;
+               clock::time_point  _start;
+         };
+
+      private:
+         struct window
+         {
+            window();
+            uint32_t                       blocks = 0;
+            timing_histogram               total;
+            std::vector<timing_histogram>  phases;
+            /** indexed by operation type */
+            std::vector<timing_histogram>  evaluate;
+            std::vector<timing_histogram>  apply;
+         };
+
+         static uint64_t elapsed_ns( clock::time_point start )
+         {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>( clock::now() - start ).count();
+         }
+
+         bool                                    _enabled = false;
+         bool                                    _in_block = false;
+
+         // the block being applied, only touched by the chain thread
+         clock::time_point                       _block_start;
+         std::vector<uint64_t>                   _block_phases;
+         std::vector<std::pair<int, uint64_t>>   _block_evaluate;
+         std::vector<std::pair<int, uint64_t>>   _block_apply;
+
+         mutable std::mutex                      _mutex;
+         uint32_t                                _window_blocks = default_window_blocks;
+         window                                  _current;
+         window                                  _previous;
+         uint32_t                                _last_block_num = 0;
+         uint64_t                                _last_block_ns = 0;
+         std::vector<uint64_t>                   _last_block_phases;
+         std::vector<std::pair<int, uint64_t>>   _last_block_evaluate;
+         std::vector<std::pair<int, uint64_t>>   _last_block_apply;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::timing_histogram, (count)(total_ns)(max_ns)(buckets) )
+FC_REFLECT( graphene::chain::block_profile, (block_num)(total_us)(phases)(operations) )
+FC_REFLECT( graphene::chain::block_profile_stats, (blocks)(window_blocks)(total)(phases)(evaluate)(apply) )
@@ -28,13 +28,17 @@
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_database.hpp>
+#include <graphene/chain/block_profiler.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
 #include <graphene/chain/license_objects.hpp>
+#include <graphene/chain/snapshot.hpp>
+#include <graphene/chain/state_hashes.hpp>
 
 #include <graphene/db/object_database.hpp>
 #include <graphene/db/object.hpp>
 #include <graphene/db/simple_index.hpp>
+#include <graphene/db/worker_pool.hpp>
 #include <fc/optional.hpp>
 #include <fc/signals.hpp>
 
@@ -42,6 +46,7 @@
 
 #include <fc/log/logger.hpp>
 
+#include <deque>
 #include <map>
 
 namespace graphene { namespace chain {
@@ -106,6 +111,48 @@ namespace graphene { namespace chain {
           */
          void reindex(fc::path data_dir);
 
+         /**
+          * @brief Set the storage options for the block log, must be called before @ref database::open
+          */
+         void set_block_database_options( const block_database_options& options ) { _block_database_options = options; }
+         const block_database_options& get_block_database_options()const { return _block_database_options; }
+
+         /**
+          * @brief Set how many blocks @ref database::reindex reads and hashes ahead of the one it applies, on a
+          * thread of its own. 0 reads every block on the applying thread.
+          */
+         void set_reindex_prefetch_blocks( uint32_t blocks ) { _reindex_prefetch_blocks = blocks; }
+         uint32_t get_reindex_prefetch_blocks()const { return _reindex_prefetch_blocks; }
+
+         /**
+          * @brief Make @ref database::reindex check the witness and transaction signatures of the replayed blocks
+          * and the authorities they satisfy, and fail at the first block that does not pass. The prefetching thread
+          * recovers the signing keys ahead of the applying thread.
+          */
+         void set_replay_verify_signatures( bool verify ) { _replay_verify_signatures = verify; }
+         bool get_replay_verify_signatures()const { return _replay_verify_signatures; }
+
+         /**
+          * @brief Make @ref database::reindex log the phase and operation timings of every replayed block, turns
+          * on the block profiler
+          */
+         void set_replay_profile_dump( bool dump ) { _replay_profile_dump = dump; }
+
+         /**
+          * @brief Set how many threads the maintenance vote tally is split over, 0 for one per core. 1 tallies the
+          * votes and processes the fees in one pass on the applying thread.
+          */
+         void set_maintenance_threads( uint32_t threads ) { _maintenance_threads = threads; _maintenance_pool.reset(); }
+         uint32_t get_maintenance_threads()const { return _maintenance_threads; }
+
+         /**
+          * @brief With the state journal enabled, flush the object database at the last irreversible block whenever
+          * this many more blocks have become irreversible, which starts the journal over. 0 lets the journal grow
+          * until the next clean shutdown.
+          */
+         void set_journal_checkpoint_blocks( uint32_t blocks ) { _journal_checkpoint_blocks = blocks; }
+         uint32_t get_journal_checkpoint_blocks()const { return _journal_checkpoint_blocks; }
+
          /**
           * @brief wipe Delete database from disk, and potentially the raw chain as well.
           * @param include_blocks If true, delete the raw chain as well as the database.
@@ -115,6 +162,27 @@ namespace graphene { namespace chain {
          void wipe(const fc::path& data_dir, bool include_blocks);
          void close(bool rewind = true);
 
+         //////////////////// db_snapshot.cpp ////////////////////
+
+         /**
+          * @brief Writes the object state at the last irreversible block to a single checksummed file
+          *
+          * Pops the blocks after the last irreversible one, writes the snapshot and applies them again. The file
+          * also holds the blocks from the snapshot state's own last irreversible block to its head block, so a
+          * node started from it can sync with its peers. See @ref snapshot_header for the layout.
+          */
+         void create_snapshot( const fc::path& snapshot_file );
+         /**
+          * @brief Replaces the object state and blocks in data_dir with the content of a snapshot file
+          *
+          * Must be called before @ref database::open, which then resumes from the snapshot's head block and
+          * checks that the loaded state matches the snapshot's state hash.
+          *
+          * @return false without importing anything if data_dir already holds an object database or a block log,
+          * those have to be wiped first
+          */
+         bool import_snapshot( const fc::path& snapshot_file, const fc::path& data_dir, const std::string& db_version );
+
          //////////////////// db_block.cpp ////////////////////
 
          /**
@@ -127,6 +195,23 @@ namespace graphene { namespace chain {
          optional<signed_block>                          fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>                          fetch_block_by_number( uint32_t num )const;
          optional<signed_block_with_virtual_operations>  fetch_block_with_virtual_operations_by_number( uint32_t num, std::vector<uint16_t> virtual_op_id_vec)const;
+         /**
+          *  @return the packed block as written to the block log, for forwarding without an unpack/repack round
+          *  trip. Blocks that only live in the fork database are not returned.
+          */
+         optional<vector<char>>                          fetch_raw_block_by_id( const block_id_type& id )const;
+         optional<vector<char>>                          fetch_raw_block_by_number( uint32_t num )const;
+         /** @return the lowest block number still in the block log, blocks below it were pruned */
+         uint32_t                                        first_stored_block_num()const;
+         /**
+          *  @return the hashes of the state after block_num, known for the head block and, with state hash
+          *  tracking on, the last state_hash_history_size blocks pushed since it was turned on
+          */
+         optional<state_hashes>                          get_state_hashes( uint32_t block_num )const;
+         static const size_t                             state_hash_history_size = 1000;
+         /** times the phases of applying blocks and the evaluators of their operations, disabled by default */
+         block_profiler&                                 get_block_profiler() { return _block_profiler; }
+         const block_profiler&                           get_block_profiler()const { return _block_profiler; }
          const signed_transaction&                       get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type>                      get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -565,6 +650,13 @@ namespace graphene { namespace chain {
           */
          processed_transaction validate_transaction( const signed_transaction& trx );
 
+         /**
+          * Recovers the signature keys of the transactions on worker threads ahead of applying them, so checking
+          * their authority on this thread needs no key recovery. Transactions whose keys fail to recover are left
+          * for the authority check to reject.
+          */
+         void precompute_signature_keys( const vector<const signed_transaction*>& transactions );
+
          /** when popping a block, the transactions that were removed get cached here so they
           * can be reapplied at the proper time */
          std::deque< signed_transaction >       _popped_tx;
@@ -624,24 +716,37 @@ namespace graphene { namespace chain {
        public:
          // these were formerly private, but they have a fairly well-defined API, so let's make them public
          void                  apply_block( const signed_block& next_block, uint32_t skip = skip_nothing );
+         /** applies next_block with its digests computed beforehand */
+         void                  apply_block( const signed_block& next_block, uint32_t skip, const block_digests& digests );
          processed_transaction apply_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
          operation_result      apply_operation( transaction_evaluation_state& eval_state, const operation& op );
       private:
-         void                  _apply_block( const signed_block& next_block );
+         void                  _apply_block( const signed_block& next_block, const block_digests& digests );
          processed_transaction _apply_transaction( const signed_transaction& trx );
+         processed_transaction _apply_transaction( const signed_transaction& trx, const transaction_id_type& trx_id );
 
          ///Steps involved in applying a new block
          ///@{
 
          const witness_object& validate_block_header( uint32_t skip, const signed_block& next_block )const;
          const witness_object& _validate_block_header( const signed_block& next_block )const;
-         void create_block_summary(const signed_block& next_block);
+         void create_block_summary(const signed_block& next_block, const block_id_type& next_block_id);
+         /// Records the head block's state in the object_database journal and the state hash history, call after
+         /// every commit or pop
+         void record_head_state();
+         /**
+          * Flushes the state of the last irreversible block once the journal spans _journal_checkpoint_blocks of them.
+          * The blocks after it are neither popped nor applied again, the flush looks past their undo states.
+          */
+         void checkpoint_journal();
+         state_hashes head_state_hashes()const;
 
          //////////////////// db_update.cpp ////////////////////
 
-         void update_global_dynamic_data( const signed_block& b );
+         void update_global_dynamic_data( const signed_block& b, const block_id_type& b_id );
          void update_signing_witness(const witness_object& signing_witness, const signed_block& new_block);
          void update_last_irreversible_block();
+         void prune_block_log();
          void clear_expired_transactions();
          void clear_expired_proposals();
          void clear_expired_orders();
@@ -703,6 +808,34 @@ private:
           *  the fork tree relatively simple.
           */
          block_database   _block_id_to_block;
+         block_database_options _block_database_options;
+         uint32_t               _reindex_prefetch_blocks = 1000;
+         bool                   _replay_verify_signatures = false;
+         /** set while reindex() verifies signatures, _apply_block() then checks those of the transactions as well */
+         bool                   _verify_block_transaction_signatures = false;
+         bool                   _replay_profile_dump = false;
+         /** set while reindex() runs, the block log is pruned once at its end rather than on every block */
+         bool                   _reindexing = false;
+         uint32_t               _journal_checkpoint_blocks = 10000;
+         /** the last irreversible block at the last flush, checkpoint_journal() counts from it */
+         uint32_t               _journal_checkpoint_block = 0;
+         block_profiler         _block_profiler;
+
+         /** the db_version passed to open(), recorded in snapshots */
+         std::string               _db_version;
+         /** header of a snapshot imported for the next open() to verify */
+         optional<snapshot_header> _imported_snapshot;
+         void verify_imported_snapshot();
+
+         /** state hashes of the recent blocks in block order, see get_state_hashes() */
+         std::deque<state_hashes>  _state_hash_history;
+
+         /** threads of precompute_signature_keys(), started on first use */
+         std::unique_ptr<worker_pool> _signature_pool;
+
+         /** threads of the maintenance vote tally, started on first use */
+         uint32_t                     _maintenance_threads = 1;
+         std::unique_ptr<worker_pool> _maintenance_pool;
 
          /**
           * Contains the set of ops that are in the process of being applied from
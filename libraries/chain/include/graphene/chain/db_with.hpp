@@ -76,6 +76,24 @@ struct pending_transactions_restorer
 
    ~pending_transactions_restorer()
    {
+      try
+      {
+         vector<const signed_transaction*> transactions;
+         transactions.reserve( _db._popped_tx.size() + _pending_transactions.size() );
+         for( const auto& tx : _db._popped_tx )
+            transactions.push_back( &tx );
+         for( const auto& tx : _pending_transactions )
+            transactions.push_back( &tx );
+         _db.precompute_signature_keys( transactions );
+      }
+      catch( const fc::exception& )
+      {
+      }
+      catch( ... )
+      {
+         // precomputing is only a speedup, the transactions below are restored either way
+      }
+
       for( const auto& tx : _db._popped_tx )
       {
          try {
@@ -29,6 +29,7 @@
 #include <graphene/db/generic_index.hpp>
 
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 
 namespace graphene {
 namespace chain {
@@ -52,7 +53,7 @@ class frequency_history_record_object : public graphene::db::abstract_object<fre
         comment(comment) {}
 };
 
-struct by_time;
+struct by_time;  // Ranked, for paging.
 struct by_frequency;
 
 typedef multi_index_container<
@@ -62,7 +63,7 @@ typedef multi_index_container<
         tag<by_id>, 
         member<object, object_id_type, &object::id>
       >,
-      ordered_unique<tag<by_time>,
+      ranked_unique<tag<by_time>,
         composite_key<frequency_history_record_object,
           member<frequency_history_record_object, time_point_sec, &frequency_history_record_object::time>,
           member<object, object_id_type, &object::id>
@@ -210,6 +210,12 @@ namespace graphene { namespace chain {
           */
          account_id_type fee_pool_account_id;
 
+         /**
+          * Set while the reset of the spending limits is spread over blocks, the vault whose limit the next block
+          * resets first.
+          */
+         optional<account_id_type> next_spend_limit_reset_account;
+
          enum dynamic_flag_bits
          {
             /**
@@ -259,6 +265,7 @@ FC_REFLECT_DERIVED( graphene::chain::dynamic_global_property_object, (graphene::
                     (external_btc_price)
                     (last_daily_dascoin_price)
                     (fee_pool_account_id)
+                    (next_spend_limit_reset_account)
                   )
 
 FC_REFLECT( graphene::chain::global_property_object::daspay,
@@ -26,7 +26,7 @@
 #include <graphene/chain/protocol/base.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/chain/upgrade_type.hpp>
-#include <graphene/db/generic_index.hpp>
+#include <graphene/db/dense_index.hpp>
 #include <graphene/db/object.hpp>
 
 #include <boost/multi_index/composite_key.hpp>
@@ -97,6 +97,7 @@ namespace graphene { namespace chain {
         time_point_sec issued_on_blockchain;
         upgrade_type balance_upgrade;
         vector<pair<upgrade_event_id_type, time_point_sec>> upgrades;
+        flat_set<upgrade_event_id_type> applied_upgrades;  // The events in upgrades, for membership tests.
 
         using upgrade_policy = detail::policy;
 
@@ -132,6 +133,17 @@ namespace graphene { namespace chain {
         {
           return amount + non_upgradeable_amount;
         }
+
+        bool upgraded_by(upgrade_event_id_type upgrade) const
+        {
+          return applied_upgrades.find(upgrade) != applied_upgrades.end();
+        }
+
+        void add_upgrade(upgrade_event_id_type upgrade, time_point_sec time)
+        {
+          upgrades.emplace_back(upgrade, time);
+          applied_upgrades.insert(upgrade);
+        }
       };
       typedef vector<license_history_record> array_t;
 
@@ -302,7 +314,7 @@ namespace graphene { namespace chain {
     >
   > license_information_multi_index_type;
 
-  typedef generic_index<license_information_object, license_information_multi_index_type> license_information_index;
+  typedef dense_index<license_information_object, license_information_multi_index_type> license_information_index;
 
   struct by_name;
   struct by_amount;
@@ -339,6 +351,7 @@ FC_REFLECT( graphene::chain::license_information_object::license_history_record,
             (issued_on_blockchain)
             (balance_upgrade)
             (upgrades)
+            (applied_upgrades)
           )
 
 FC_REFLECT_DERIVED( graphene::chain::license_information_object, (graphene::db::object),
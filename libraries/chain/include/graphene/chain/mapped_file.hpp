@@ -0,0 +1,111 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/interprocess/file_mapping.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace graphene { namespace chain { namespace detail {
+
+   /**
+    * Flushes a file, or the entries of a directory, from the OS cache to the disk. A rename is only
+    * durable once the directory holding it is synced, and only safe once the renamed files are.
+    */
+   inline void sync_to_disk( const fc::path& p )
+   {
+      const int fd = ::open( p.generic_string().c_str(), O_RDONLY );
+      FC_ASSERT( fd >= 0, "Could not open ${p} to sync it", ("p", p) );
+      const int result = ::fsync( fd );
+      ::close( fd );
+      FC_ASSERT( result == 0, "Could not sync ${p}", ("p", p) );
+   }
+
+   /**
+    * Read-only view of a file which a single writer appends to or overwrites in place. Whenever a
+    * reader asks for bytes past the end of the current mapping the file is mapped again at its
+    * current size. Readers only copy out of the mapping, so they never share a stream position.
+    *
+    * Truncating the file while another thread reads its tail is not supported.
+    */
+   class mapped_file
+   {
+      public:
+         explicit mapped_file( const fc::path& p ):_path(p){}
+
+         const fc::path& path()const { return _path; }
+
+         /** Copies len bytes at pos into out, @return false if the file is shorter than pos + len */
+         bool read( uint64_t pos, char* out, size_t len )const
+         {
+            auto region = region_covering( pos + len );
+            if( !region )
+               return false;
+            if( len )
+               std::memcpy( out, (const char*)region->get_address() + pos, len );
+            return true;
+         }
+
+         /** Drops the current mapping, must be called after the file was truncated */
+         void reset()
+         {
+            std::lock_guard<std::mutex> guard( _remap_mutex );
+            std::atomic_store( &_region, std::shared_ptr<fc::mapped_region>() );
+         }
+
+      private:
+         std::shared_ptr<fc::mapped_region> region_covering( uint64_t end )const
+         {
+            auto region = std::atomic_load( &_region );
+            if( region && region->get_size() >= end )
+               return region;
+
+            std::lock_guard<std::mutex> guard( _remap_mutex );
+            region = std::atomic_load( &_region );
+            if( region && region->get_size() >= end )
+               return region;
+            if( !fc::exists( _path ) )
+               return std::shared_ptr<fc::mapped_region>();
+            const uint64_t file_size = fc::file_size( _path );
+            if( file_size < end || file_size == 0 )
+               return std::shared_ptr<fc::mapped_region>();
+            fc::file_mapping fm( _path.generic_string().c_str(), fc::read_only );
+            region = std::make_shared<fc::mapped_region>( fm, fc::read_only, 0, file_size );
+            std::atomic_store( &_region, region );
+            return region;
+         }
+
+         fc::path                                    _path;
+         mutable std::mutex                          _remap_mutex;
+         mutable std::shared_ptr<fc::mapped_region>  _region;
+   };
+
+} } } // graphene::chain::detail
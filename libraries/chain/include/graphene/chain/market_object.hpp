@@ -97,7 +97,8 @@ typedef multi_index_container<
    >
 > limit_order_multi_index_type;
 
-typedef generic_index<limit_order_object, limit_order_multi_index_type> limit_order_index;
+typedef generic_index<limit_order_object, limit_order_multi_index_type,
+                      node_pool_allocator<limit_order_object>> limit_order_index;
 
 struct market_key
 {
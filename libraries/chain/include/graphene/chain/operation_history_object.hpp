@@ -75,7 +75,8 @@ namespace graphene { namespace chain {
       >
    > operation_history_multi_index_type;
 
-   typedef generic_index<operation_history_object, operation_history_multi_index_type> operation_history_index;
+   typedef generic_index<operation_history_object, operation_history_multi_index_type,
+                         node_pool_allocator<operation_history_object>> operation_history_index;
 
    /**
     *  @brief a node in a linked list of operation_history_objects
@@ -139,7 +140,8 @@ namespace graphene { namespace chain {
       >
    > account_transaction_history_multi_index_type;
 
-   typedef generic_index<account_transaction_history_object, account_transaction_history_multi_index_type> account_transaction_history_index;
+   typedef generic_index<account_transaction_history_object, account_transaction_history_multi_index_type,
+                         node_pool_allocator<account_transaction_history_object>> account_transaction_history_index;
 
 
 } } // graphene::chain
@@ -57,6 +57,25 @@ namespace graphene { namespace chain {
       vector<processed_transaction> transactions;
    };
 
+   /**
+    * @brief The digests of a signed_block that block processing needs, computed once
+    *
+    * signed_block recomputes its id, merkle root and transaction ids on every call, as its fields may still
+    * change. A block taken in for processing no longer does, so the chain computes these once per block and
+    * passes them along.
+    */
+   struct block_digests
+   {
+      block_digests() {}
+      /** @param with_merkle_root false to leave merkle_root unset, for blocks whose merkle root is not checked */
+      explicit block_digests( const signed_block& b, bool with_merkle_root = true );
+
+      block_id_type                id;
+      optional<checksum_type>      merkle_root;
+      /** ids of the block's transactions, in block order */
+      vector<transaction_id_type>  transaction_ids;
+   };
+
    struct signed_block_with_virtual_operations : public signed_block
    {
       vector<operation> virtual_operations;
@@ -25,6 +25,8 @@
 #include <graphene/chain/protocol/base.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/chain/protocol/withdrawal_limit.hpp>
+#include <graphene/chain/protocol/spending_limit_reset.hpp>
+#include <graphene/chain/protocol/delayed_operations_resolver.hpp>
 #include <fc/smart_ref_fwd.hpp>
 
 namespace graphene { namespace chain { struct fee_schedule; } }
@@ -75,7 +77,8 @@ namespace graphene { namespace chain {
       bool                    enable_cycle_issuing = true;
       bool                    enable_dascoin_queue = false;
 
-      using chain_parameters_extension = static_variant<void_t, asset_id_type, withdrawal_limit_type>;
+      using chain_parameters_extension = static_variant<void_t, asset_id_type, withdrawal_limit_type, spending_limit_reset_batch_type,
+                                                         delayed_operations_resolver_batch_type>;
       using chain_parameters_extension_type = flat_set<chain_parameters_extension>;
       chain_parameters_extension_type         extensions;
 
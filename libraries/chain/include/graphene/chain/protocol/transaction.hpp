@@ -167,10 +167,34 @@ namespace graphene { namespace chain {
 
       flat_set<public_key_type> get_signature_keys( const chain_id_type& chain_id )const;
 
+      /**
+       * Recovers the signature keys ahead of time, get_signature_keys() then returns them without recovery for as
+       * long as the transaction and its signatures stay unchanged. Different transactions may be precomputed
+       * concurrently.
+       */
+      void precompute_signature_keys( const chain_id_type& chain_id )const;
+
+      /** @return the keys of the last precompute_signature_keys(), if the transaction is unchanged since */
+      optional< flat_set<public_key_type> > get_precomputed_signature_keys( const chain_id_type& chain_id )const;
+
       vector<signature_type> signatures;
 
       /// Removes all operations and signatures
       void clear() { operations.clear(); signatures.clear(); }
+
+   private:
+      /** keys recovered by precompute_signature_keys(), with the digest and signatures they were recovered from */
+      struct precomputed_keys
+      {
+         digest_type               digest;
+         vector<signature_type>    signatures;
+         flat_set<public_key_type> keys;
+      };
+      /** not serialized, copies of the transaction share it until either recomputes */
+      mutable std::shared_ptr<const precomputed_keys> _precomputed_keys;
+
+      /** @return _precomputed_keys if they were recovered from digest and the current signatures, else null */
+      std::shared_ptr<const precomputed_keys> find_precomputed_keys( const digest_type& digest )const;
    };
 
    void verify_authority( const vector<operation>& ops, const flat_set<public_key_type>& sigs,
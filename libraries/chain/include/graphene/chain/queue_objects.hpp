@@ -29,6 +29,7 @@
 #include <graphene/db/object.hpp>
 
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 
 namespace graphene { namespace chain {
 
@@ -69,14 +70,14 @@ namespace graphene { namespace chain {
   //////////////////////////////
 
   struct by_account;
-  struct by_time;
+  struct by_time;  // Ranked, the position of a submission in the queue and the submission at a position are O(log n).
   typedef multi_index_container<
     reward_queue_object,
     indexed_by<
       ordered_unique< tag<by_id>,
         member<object, object_id_type, &object::id>
       >,
-      ordered_unique< tag<by_time>,
+      ranked_unique< tag<by_time>,
         composite_key< reward_queue_object,
           member< reward_queue_object, time_point_sec, &reward_queue_object::time>,
           member< object, object_id_type, &object::id>
@@ -91,7 +92,8 @@ namespace graphene { namespace chain {
     >
   > reward_queue_multi_index_type;
 
-  typedef generic_index<reward_queue_object, reward_queue_multi_index_type> reward_queue_index;
+  typedef generic_index<reward_queue_object, reward_queue_multi_index_type,
+                        node_pool_allocator<reward_queue_object>> reward_queue_index;
 
 } }  // namespace graphene::chain
 
@@ -0,0 +1,136 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <graphene/chain/protocol/block.hpp>
+
+#include <fc/thread/future.hpp>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace fc { class thread; }
+
+namespace graphene { namespace chain {
+   namespace detail { class mapped_file; }
+
+   /**
+    * @class segmented_block_log
+    * @brief Block storage split into fixed-size segments of consecutive block numbers
+    *
+    * Segment n holds blocks [n * blocks_per_segment, (n+1) * blocks_per_segment) in two files: n.g.log with
+    * the packed (optionally zlib-compressed) blocks and n.g.idx with one fixed-size entry per block number,
+    * where g is the segment's generation. A block is found in O(1): segment and slot from its number, then a
+    * single read from the log.
+    *
+    * Blocks that were removed or overwritten by a fork switch leave dead bytes in their segment's log. When
+    * the writer moves on to a new segment, the previous one is compacted in the background: live blocks are
+    * copied into generation g+1, whose index is renamed into place last, so a crash at any point leaves one
+    * complete generation behind.
+    *
+    * Old history can be dropped with prune(), which deletes whole segments below a block number.
+    *
+    * There may be one writer thread (store, remove, last_entry, prune) and any number of readers.
+    */
+   class segmented_block_log
+   {
+      public:
+         struct entry
+         {
+            uint64_t      offset = 0;       ///< position of the stored bytes in the segment's log
+            uint32_t      stored_size = 0;  ///< bytes in the log, 0 if the block was removed
+            uint32_t      packed_size = 0;  ///< size of the packed block, larger than stored_size if compressed
+            block_id_type block_id;
+         };
+
+         segmented_block_log( const fc::path& dir, uint32_t blocks_per_segment, bool compress );
+         ~segmented_block_log();
+
+         /** @return true if no block was ever stored */
+         bool empty()const;
+         /** @return the lowest block number the log may still hold, 1 unless segments were pruned */
+         uint32_t first_block_num()const;
+         void flush();
+
+         void store( const block_id_type& id, const vector<char>& packed_block );
+         void remove( const block_id_type& id );
+
+         /**
+          * Looks up the entry for block_num and, if data is set, the packed block it describes. Both come from
+          * the same generation of the segment even if it is compacted concurrently.
+          * @return false if there is no entry for block_num
+          */
+         bool read( uint32_t block_num, entry& e, vector<char>* data = nullptr )const;
+
+         /**
+          * @return the entry of the highest block that can be read back and matches its id. Entries after it
+          * which cannot are cleared.
+          */
+         optional<entry> last_entry();
+
+         /**
+          * Rewrites a segment without its removed and orphaned blocks.
+          * @return false if the segment was written to in the meantime and the result was discarded
+          */
+         bool compact_segment( uint32_t segment_num );
+         /**
+          * Deletes every segment that only holds blocks below first_kept_block. Segments go as a whole, so up
+          * to blocks_per_segment - 1 blocks below first_kept_block are kept as well.
+          * @return the number of segments deleted
+          */
+         uint32_t prune( uint32_t first_kept_block );
+
+         /** Blocks until all background compactions scheduled so far are done */
+         void wait_for_compaction();
+
+      private:
+         struct segment_files;
+
+         fc::path segment_path( uint32_t segment_num, uint32_t generation, const char* extension )const;
+         std::shared_ptr<segment_files> get_segment( uint32_t segment_num )const;
+         void open_writer( uint32_t segment_num );
+         void close_writer();
+         void write_entry( uint32_t block_num, const entry& e );
+         void schedule_compaction( uint32_t segment_num );
+
+         fc::path                                           _dir;
+         uint32_t                                           _blocks_per_segment;
+         bool                                               _compress;
+
+         mutable std::mutex                                 _segments_mutex;
+         std::map< uint32_t, std::shared_ptr<segment_files> > _segments;
+
+         /** held by the writer and while compaction swaps in a new generation */
+         std::mutex                                         _write_mutex;
+         std::map< uint32_t, uint64_t >                     _segment_writes;
+         optional<uint32_t>                                 _writer_segment;
+         std::fstream                                       _writer_log;
+         std::fstream                                       _writer_idx;
+
+         std::unique_ptr<fc::thread>                        _compaction_thread;
+         fc::future<void>                                   _compaction_done;
+   };
+} }
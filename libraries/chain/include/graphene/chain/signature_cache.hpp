@@ -0,0 +1,87 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <graphene/chain/protocol/types.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace graphene { namespace chain {
+
+   struct signature_cache_stats
+   {
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+      uint64_t entries = 0;
+      uint64_t capacity = 0;
+   };
+
+   /**
+    * @class signature_cache
+    * @brief Public keys recovered from transaction signatures, keyed by signature digest and signature
+    *
+    * One cache serves the whole process, so a signature is recovered once whether it is seen first in the pending
+    * queue, while generating a block or inside a received block. The cache keeps two generations of entries: once
+    * the current one holds half the capacity it replaces the previous one, and hits in the previous generation are
+    * carried over to the current one.
+    */
+   class signature_cache
+   {
+      public:
+         static const size_t default_capacity = 100000;
+
+         static signature_cache& instance();
+
+         /** @return the key that made signature over digest, recovered only if it is not cached */
+         public_key_type recover( const digest_type& digest, const signature_type& signature );
+
+         /** Sets the number of keys kept, 0 turns caching off */
+         void set_capacity( size_t capacity );
+         signature_cache_stats get_stats()const;
+         void clear();
+
+      private:
+         typedef std::pair<digest_type, signature_type> key_type;
+         struct key_hash
+         {
+            size_t operator()( const key_type& key )const;
+         };
+         typedef std::unordered_map<key_type, public_key_type, key_hash> generation_type;
+
+         /** called with _mutex held */
+         void insert( const key_type& key, const public_key_type& value );
+
+         mutable std::mutex    _mutex;
+         generation_type       _current;
+         generation_type       _previous;
+         size_t                _capacity = default_capacity;
+         std::atomic<uint64_t> _hits{0};
+         std::atomic<uint64_t> _misses{0};
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::signature_cache_stats, (hits)(misses)(entries)(capacity) )
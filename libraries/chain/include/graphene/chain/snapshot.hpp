@@ -0,0 +1,60 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <graphene/chain/protocol/types.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/time.hpp>
+
+namespace graphene { namespace chain {
+
+   /** Start of a state snapshot file */
+   const uint64_t snapshot_magic  = 0x544f4853504e5347ull; // "GSNPSHOT"
+   const uint32_t snapshot_format = 1;
+
+   /**
+    * @brief Describes the chain state saved in a snapshot file
+    *
+    * A snapshot file holds snapshot_magic, this header, the blocks from the last irreversible one up to the
+    * head block, the saved file of every index as (space, type, size, bytes) and finally a sha256 of all of
+    * the above. See database::create_snapshot() and database::import_snapshot().
+    */
+   struct snapshot_header
+   {
+      uint32_t           format = snapshot_format;
+      /** the db_version the database was opened with, a snapshot only loads into the same version */
+      std::string        db_version;
+      chain_id_type      chain_id;
+      uint32_t           head_block_num = 0;
+      block_id_type      head_block_id;
+      fc::time_point_sec head_block_time;
+      /** object_database::get_state_hash() at the head block */
+      fc::sha256         state_hash;
+   };
+
+} }
+
+FC_REFLECT( graphene::chain::snapshot_header,
+            (format)(db_version)(chain_id)(head_block_num)(head_block_id)(head_block_time)(state_hash) )
@@ -0,0 +1,50 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <graphene/chain/protocol/types.hpp>
+#include <graphene/db/object_database.hpp>
+
+#include <fc/crypto/sha256.hpp>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Fingerprint of the object state after a block
+    *
+    * Two nodes that applied the same block agree on state_hash. If they do not, comparing the indices entry by
+    * entry names the indices that diverged. See database::get_state_hashes().
+    */
+   struct state_hashes
+   {
+      uint32_t                         block_num = 0;
+      block_id_type                    block_id;
+      /** object_database::get_state_hash() */
+      fc::sha256                       state_hash;
+      vector<graphene::db::index_hash> indices;
+   };
+
+} }
+
+FC_REFLECT( graphene::chain::state_hashes, (block_num)(block_id)(state_hash)(indices) )
@@ -68,7 +68,8 @@ namespace graphene { namespace chain {
       >
    > transaction_multi_index_type;
 
-   typedef generic_index<transaction_object, transaction_multi_index_type> transaction_index;
+   typedef generic_index<transaction_object, transaction_multi_index_type,
+                         node_pool_allocator<transaction_object>> transaction_index;
 } }
 
 FC_REFLECT_DERIVED( graphene::chain::transaction_object, (graphene::db::object), (trx)(trx_id) )
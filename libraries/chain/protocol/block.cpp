@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 #include <graphene/chain/protocol/block.hpp>
+#include <graphene/chain/signature_cache.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/bitutil.hpp>
 #include <algorithm>
@@ -49,7 +50,8 @@ namespace graphene { namespace chain {
 
    fc::ecc::public_key signed_block_header::signee()const
    {
-      return fc::ecc::public_key( witness_signature, digest(), true/*enforce canonical*/ );
+      // the cache enforces canonical signatures as well
+      return signature_cache::instance().recover( digest(), witness_signature );
    }
 
    void signed_block_header::sign( const fc::ecc::private_key& signer )
@@ -89,4 +91,14 @@ namespace graphene { namespace chain {
       return checksum_type::hash( ids[0] );
    }
 
+   block_digests::block_digests( const signed_block& b, bool with_merkle_root )
+   : id( b.id() )
+   {
+      transaction_ids.reserve( b.transactions.size() );
+      for( const auto& trx : b.transactions )
+         transaction_ids.push_back( trx.id() );
+      if( with_merkle_root )
+         merkle_root = b.calculate_merkle_root();
+   }
+
 } }
@@ -260,6 +260,13 @@ namespace graphene { namespace chain {
                  "Maximum transaction expiration time must be greater than a block interval" );
       FC_ASSERT( maximum_proposal_lifetime - committee_proposal_review_period > block_interval,
                  "Committee proposal review period must be less than the maximum proposal lifetime" );
+      for( const auto& ext : extensions )
+         if( ext.which() == chain_parameters_extension::tag< spending_limit_reset_batch_type >::value )
+            FC_ASSERT( ext.get<spending_limit_reset_batch_type>().accounts_per_block > 0,
+                       "Spending limits must be reset for at least one account per block" );
+         else if( ext.which() == chain_parameters_extension::tag< delayed_operations_resolver_batch_type >::value )
+            FC_ASSERT( ext.get<delayed_operations_resolver_batch_type>().operations_per_block > 0,
+                       "Delayed operations resolver must resolve at least one operation per block" );
    }
 
    void chain_parameters::apply_fee_asset_id()
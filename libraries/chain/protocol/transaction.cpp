@@ -24,6 +24,7 @@
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 #include <graphene/chain/protocol/block.hpp>
+#include <graphene/chain/signature_cache.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/bitutil.hpp>
 #include <fc/smart_ref_impl.hpp>
@@ -301,20 +302,54 @@ void verify_authority( const vector<operation>& ops, const flat_set<public_key_t
 } FC_CAPTURE_AND_RETHROW( (ops)(sigs) ) }
 
 
-flat_set<public_key_type> signed_transaction::get_signature_keys( const chain_id_type& chain_id )const
-{ try {
-   auto d = sig_digest( chain_id );
+static flat_set<public_key_type> recover_signature_keys( const digest_type& digest, const vector<signature_type>& signatures )
+{
    flat_set<public_key_type> result;
    for( const auto&  sig : signatures )
    {
       GRAPHENE_ASSERT(
-         result.insert( fc::ecc::public_key(sig,d) ).second,
+         result.insert( signature_cache::instance().recover( digest, sig ) ).second,
          tx_duplicate_sig,
          "Duplicate Signature detected" );
    }
    return result;
+}
+
+std::shared_ptr<const signed_transaction::precomputed_keys> signed_transaction::find_precomputed_keys( const digest_type& digest )const
+{
+   auto precomputed = _precomputed_keys;
+   if( precomputed && precomputed->digest == digest && precomputed->signatures == signatures )
+      return precomputed;
+   return std::shared_ptr<const precomputed_keys>();
+}
+
+flat_set<public_key_type> signed_transaction::get_signature_keys( const chain_id_type& chain_id )const
+{ try {
+   auto d = sig_digest( chain_id );
+   if( const auto precomputed = find_precomputed_keys( d ) )
+      return precomputed->keys;
+   return recover_signature_keys( d, signatures );
 } FC_CAPTURE_AND_RETHROW() }
 
+void signed_transaction::precompute_signature_keys( const chain_id_type& chain_id )const
+{ try {
+   auto d = sig_digest( chain_id );
+   if( find_precomputed_keys( d ) )
+      return;
+   auto precomputed = std::make_shared<precomputed_keys>();
+   precomputed->digest = d;
+   precomputed->signatures = signatures;
+   precomputed->keys = recover_signature_keys( precomputed->digest, signatures );
+   _precomputed_keys = std::move( precomputed );
+} FC_CAPTURE_AND_RETHROW() }
+
+optional< flat_set<public_key_type> > signed_transaction::get_precomputed_signature_keys( const chain_id_type& chain_id )const
+{
+   if( const auto precomputed = find_precomputed_keys( sig_digest( chain_id ) ) )
+      return precomputed->keys;
+   return optional< flat_set<public_key_type> >();
+}
+
 
 
 set<public_key_type> signed_transaction::get_required_signatures(
@@ -0,0 +1,470 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/segmented_block_log.hpp>
+#include <graphene/chain/mapped_file.hpp>
+#include <graphene/chain/protocol/fee_schedule.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/smart_ref_impl.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   vector<char> zlib_filter( const vector<char>& in, bool compress )
+   {
+      namespace bio = boost::iostreams;
+      bio::filtering_istreambuf buf;
+      if( compress )
+         buf.push( bio::zlib_compressor() );
+      else
+         buf.push( bio::zlib_decompressor() );
+      buf.push( bio::array_source( in.data(), in.size() ) );
+      vector<char> out;
+      bio::copy( buf, bio::back_inserter( out ) );
+      return out;
+   }
+
+}
+
+struct segmented_block_log::segment_files
+{
+   segment_files( uint32_t generation, const fc::path& log_path, const fc::path& idx_path )
+   :generation(generation),log(log_path),idx(idx_path){}
+
+   uint32_t            generation;
+   detail::mapped_file log;
+   detail::mapped_file idx;
+};
+
+segmented_block_log::segmented_block_log( const fc::path& dir, uint32_t blocks_per_segment, bool compress )
+:_dir(dir),_blocks_per_segment(blocks_per_segment),_compress(compress)
+{ try {
+   FC_ASSERT( _blocks_per_segment > 0 );
+   fc::create_directories( _dir );
+
+   // Changing the segment size would move every block to a different slot
+   const fc::path config_path = _dir / "blocks_per_segment";
+   if( fc::exists( config_path ) )
+   {
+      std::string stored;
+      fc::read_file_contents( config_path, stored );
+      FC_ASSERT( stored == fc::to_string( _blocks_per_segment ),
+                 "Block log segments were written with ${s} blocks per segment, not ${n}",
+                 ("s", stored)("n", _blocks_per_segment) );
+   }
+   else
+   {
+      std::ofstream out( config_path.generic_string(), std::ofstream::binary | std::ofstream::trunc );
+      out << _blocks_per_segment;
+   }
+
+   // Pick the newest complete generation of every segment. A generation is complete once its index
+   // exists, anything else is left over from an interrupted compaction.
+   std::map< uint32_t, uint32_t > generations;
+   vector<fc::path> files;
+   for( fc::directory_iterator itr( _dir ); itr != fc::directory_iterator(); ++itr )
+   {
+      const fc::path file = *itr;
+      files.push_back( file );
+      const std::string name = file.filename().string();
+      const auto first_dot = name.find( '.' );
+      const auto second_dot = name.find( '.', first_dot + 1 );
+      if( first_dot == std::string::npos || second_dot == std::string::npos || name.substr( second_dot ) != ".idx" )
+         continue;
+      const uint32_t segment_num = std::stoul( name.substr( 0, first_dot ) );
+      const uint32_t generation = std::stoul( name.substr( first_dot + 1, second_dot - first_dot - 1 ) );
+      if( fc::exists( segment_path( segment_num, generation, ".log" ) ) &&
+          ( !generations.count( segment_num ) || generations[segment_num] < generation ) )
+         generations[segment_num] = generation;
+   }
+   for( const auto& item : generations )
+      _segments[item.first] = std::make_shared<segment_files>( item.second,
+                                                               segment_path( item.first, item.second, ".log" ),
+                                                               segment_path( item.first, item.second, ".idx" ) );
+   for( const auto& file : files )
+   {
+      if( file.filename() == config_path.filename() )
+         continue;
+      bool live = false;
+      for( const auto& item : _segments )
+         live |= file.filename() == item.second->log.path().filename() ||
+                 file.filename() == item.second->idx.path().filename();
+      if( !live )
+      {
+         wlog( "Removing stale block log file ${f}", ("f", file) );
+         fc::remove( file );
+      }
+   }
+} FC_CAPTURE_AND_RETHROW( (dir)(blocks_per_segment) ) }
+
+segmented_block_log::~segmented_block_log()
+{
+   try
+   {
+      wait_for_compaction();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Block log compaction failed: ${e}", ("e", e.to_detail_string()) );
+   }
+   if( _compaction_thread )
+      _compaction_thread->quit();
+   close_writer();
+}
+
+fc::path segmented_block_log::segment_path( uint32_t segment_num, uint32_t generation, const char* extension )const
+{
+   return _dir / ( fc::to_string( segment_num ) + "." + fc::to_string( generation ) + extension );
+}
+
+std::shared_ptr<segmented_block_log::segment_files> segmented_block_log::get_segment( uint32_t segment_num )const
+{
+   std::lock_guard<std::mutex> guard( _segments_mutex );
+   auto itr = _segments.find( segment_num );
+   if( itr == _segments.end() )
+      return std::shared_ptr<segment_files>();
+   return itr->second;
+}
+
+bool segmented_block_log::empty()const
+{
+   std::lock_guard<std::mutex> guard( _segments_mutex );
+   return _segments.empty();
+}
+
+uint32_t segmented_block_log::first_block_num()const
+{
+   std::lock_guard<std::mutex> guard( _segments_mutex );
+   if( _segments.empty() )
+      return 1;
+   return std::max( _segments.begin()->first * _blocks_per_segment, uint32_t(1) );
+}
+
+void segmented_block_log::flush()
+{
+   std::lock_guard<std::mutex> guard( _write_mutex );
+   if( _writer_segment )
+   {
+      _writer_log.flush();
+      _writer_idx.flush();
+   }
+}
+
+void segmented_block_log::open_writer( uint32_t segment_num )
+{
+   if( _writer_segment && *_writer_segment == segment_num )
+      return;
+   close_writer();
+
+   auto segment = get_segment( segment_num );
+   if( !segment )
+   {
+      segment = std::make_shared<segment_files>( 0, segment_path( segment_num, 0, ".log" ),
+                                                    segment_path( segment_num, 0, ".idx" ) );
+      {
+         std::ofstream create_log( segment->log.path().generic_string(), std::ofstream::binary | std::ofstream::trunc );
+         std::ofstream create_idx( segment->idx.path().generic_string(), std::ofstream::binary | std::ofstream::trunc );
+         FC_ASSERT( create_log && create_idx, "Failed to create block log segment ${s}", ("s", segment_num) );
+      }
+      std::lock_guard<std::mutex> guard( _segments_mutex );
+      _segments[segment_num] = segment;
+   }
+
+   _writer_log.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+   _writer_idx.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+   _writer_log.open( segment->log.path().generic_string(), std::fstream::binary | std::fstream::in | std::fstream::out );
+   _writer_idx.open( segment->idx.path().generic_string(), std::fstream::binary | std::fstream::in | std::fstream::out );
+   _writer_segment = segment_num;
+}
+
+void segmented_block_log::close_writer()
+{
+   if( !_writer_segment )
+      return;
+   _writer_log.close();
+   _writer_idx.close();
+   _writer_segment.reset();
+}
+
+void segmented_block_log::write_entry( uint32_t block_num, const entry& e )
+{
+   _writer_idx.seekp( int64_t(sizeof(entry)) * ( block_num % _blocks_per_segment ) );
+   _writer_idx.write( (const char*)&e, sizeof(e) );
+   // readers map the files, so everything has to reach the page cache before the entry is visible
+   _writer_idx.flush();
+   ++_segment_writes[block_num / _blocks_per_segment];
+}
+
+void segmented_block_log::store( const block_id_type& id, const vector<char>& packed_block )
+{
+   const uint32_t block_num = block_header::num_from_id( id );
+   const uint32_t segment_num = block_num / _blocks_per_segment;
+
+   vector<char> compressed;
+   if( _compress )
+      compressed = zlib_filter( packed_block, true );
+   const bool use_compressed = _compress && compressed.size() < packed_block.size();
+   const vector<char>& bytes = use_compressed ? compressed : packed_block;
+
+   std::lock_guard<std::mutex> guard( _write_mutex );
+   const bool new_segment = !get_segment( segment_num );
+   open_writer( segment_num );
+
+   entry e;
+   _writer_log.seekp( 0, _writer_log.end );
+   e.offset      = _writer_log.tellp();
+   e.stored_size = bytes.size();
+   e.packed_size = packed_block.size();
+   e.block_id    = id;
+   _writer_log.write( bytes.data(), bytes.size() );
+   _writer_log.flush();
+   write_entry( block_num, e );
+
+   if( new_segment && segment_num > 0 && get_segment( segment_num - 1 ) )
+      schedule_compaction( segment_num - 1 );
+}
+
+void segmented_block_log::remove( const block_id_type& id )
+{
+   const uint32_t block_num = block_header::num_from_id( id );
+   entry e;
+   if( !read( block_num, e ) )
+      FC_THROW_EXCEPTION( fc::key_not_found_exception, "Block ${id} not contained in block database", ("id", id) );
+   if( e.block_id != id )
+      return;
+
+   std::lock_guard<std::mutex> guard( _write_mutex );
+   open_writer( block_num / _blocks_per_segment );
+   e.stored_size = 0;
+   e.packed_size = 0;
+   write_entry( block_num, e );
+}
+
+uint32_t segmented_block_log::prune( uint32_t first_kept_block )
+{
+   vector< std::pair< uint32_t, std::shared_ptr<segment_files> > > pruned;
+   {
+      std::lock_guard<std::mutex> guard( _write_mutex );
+      std::lock_guard<std::mutex> segments_guard( _segments_mutex );
+      while( !_segments.empty() && uint64_t( _segments.begin()->first + 1 ) * _blocks_per_segment <= first_kept_block )
+      {
+         const uint32_t segment_num = _segments.begin()->first;
+         if( _writer_segment && *_writer_segment == segment_num )
+            close_writer();
+         _segment_writes.erase( segment_num );
+         pruned.emplace_back( segment_num, _segments.begin()->second );
+         _segments.erase( _segments.begin() );
+      }
+   }
+
+   // a segment without its index is stale and gets cleaned up on open, so it goes first
+   for( const auto& segment : pruned )
+   {
+      ilog( "Pruning block log segment ${s}", ("s", segment.first) );
+      fc::remove( segment.second->idx.path() );
+      fc::remove( segment.second->log.path() );
+   }
+   return pruned.size();
+}
+
+bool segmented_block_log::read( uint32_t block_num, entry& e, vector<char>* data )const
+{
+   const auto segment = get_segment( block_num / _blocks_per_segment );
+   if( !segment )
+      return false;
+   if( !segment->idx.read( uint64_t(sizeof(entry)) * ( block_num % _blocks_per_segment ), (char*)&e, sizeof(e) ) )
+      return false;
+   if( data == nullptr )
+      return true;
+
+   data->resize( e.stored_size );
+   FC_ASSERT( segment->log.read( e.offset, data->data(), e.stored_size ),
+              "Block ${n} is past the end of its segment (maybe corrupt on disk?)", ("n", block_num) );
+   if( e.stored_size != e.packed_size )
+   {
+      *data = zlib_filter( *data, false );
+      FC_ASSERT( data->size() == e.packed_size, "Block ${n} does not decompress to its recorded size", ("n", block_num) );
+   }
+   return true;
+}
+
+optional<segmented_block_log::entry> segmented_block_log::last_entry()
+{
+   vector< std::pair< uint32_t, std::shared_ptr<segment_files> > > segments;
+   {
+      std::lock_guard<std::mutex> guard( _segments_mutex );
+      segments.assign( _segments.rbegin(), _segments.rend() );
+   }
+   for( const auto& segment : segments )
+   {
+      const uint64_t slots = fc::file_size( segment.second->idx.path() ) / sizeof(entry);
+      for( uint64_t slot = slots; slot > 0; --slot )
+      {
+         const uint32_t block_num = segment.first * _blocks_per_segment + uint32_t(slot - 1);
+         entry e;
+         vector<char> data;
+         try
+         {
+            if( !read( block_num, e, &data ) || e.stored_size == 0 )
+               continue;
+            if( fc::raw::unpack<signed_block>( data ).id() == e.block_id )
+               return e;
+         }
+         catch( const fc::exception& )
+         {
+         }
+         catch( const std::exception& )
+         {
+         }
+         wlog( "Clearing unreadable block ${n} from the block log", ("n", block_num) );
+         std::lock_guard<std::mutex> guard( _write_mutex );
+         open_writer( segment.first );
+         write_entry( block_num, entry() );
+      }
+   }
+   return optional<entry>();
+}
+
+void segmented_block_log::schedule_compaction( uint32_t segment_num )
+{
+   if( !_compaction_thread )
+      _compaction_thread.reset( new fc::thread( "block_log_compaction" ) );
+   // tasks run in order on the compaction thread, so waiting for the last one waits for all of them
+   _compaction_done = _compaction_thread->async( [this, segment_num]() {
+      try
+      {
+         compact_segment( segment_num );
+      }
+      catch( const fc::exception& e )
+      {
+         elog( "Failed to compact block log segment ${s}: ${e}", ("s", segment_num)("e", e.to_detail_string()) );
+      }
+   }, "compact_block_log_segment" );
+}
+
+void segmented_block_log::wait_for_compaction()
+{
+   if( _compaction_done.valid() )
+      _compaction_done.wait();
+}
+
+bool segmented_block_log::compact_segment( uint32_t segment_num )
+{ try {
+   std::shared_ptr<segment_files> segment;
+   uint64_t writes;
+   {
+      std::lock_guard<std::mutex> guard( _write_mutex );
+      segment = get_segment( segment_num );
+      if( !segment )
+         return true;
+      writes = _segment_writes[segment_num];
+   }
+
+   const uint64_t slots = fc::file_size( segment->idx.path() ) / sizeof(entry);
+   vector<entry> entries( slots );
+   uint64_t live_bytes = 0;
+   for( uint64_t slot = 0; slot < slots; ++slot )
+   {
+      FC_ASSERT( segment->idx.read( slot * sizeof(entry), (char*)&entries[slot], sizeof(entry) ) );
+      live_bytes += entries[slot].stored_size;
+   }
+   const uint64_t log_size = fc::file_size( segment->log.path() );
+   if( live_bytes == log_size )
+      return true;
+
+   const uint32_t generation = segment->generation + 1;
+   const fc::path log_path = segment_path( segment_num, generation, ".log" );
+   const fc::path idx_path = segment_path( segment_num, generation, ".idx" );
+   const fc::path idx_tmp_path = segment_path( segment_num, generation, ".idx.tmp" );
+   {
+      std::ofstream log( log_path.generic_string(), std::ofstream::binary | std::ofstream::trunc );
+      std::ofstream idx( idx_tmp_path.generic_string(), std::ofstream::binary | std::ofstream::trunc );
+      vector<char> data;
+      uint64_t offset = 0;
+      for( auto& e : entries )
+      {
+         if( e.stored_size > 0 )
+         {
+            data.resize( e.stored_size );
+            FC_ASSERT( segment->log.read( e.offset, data.data(), data.size() ) );
+            log.write( data.data(), data.size() );
+            e.offset = offset;
+            offset += e.stored_size;
+         }
+         else
+            e.offset = 0;
+         idx.write( (const char*)&e, sizeof(e) );
+      }
+      log.flush();
+      idx.flush();
+      FC_ASSERT( log && idx, "Failed to write compacted block log segment ${s}", ("s", segment_num) );
+   }
+   detail::sync_to_disk( log_path );
+   detail::sync_to_disk( idx_tmp_path );
+   detail::sync_to_disk( _dir );
+
+   {
+      std::lock_guard<std::mutex> guard( _write_mutex );
+      if( _segment_writes[segment_num] != writes || get_segment( segment_num ) != segment )
+      {
+         fc::remove( log_path );
+         fc::remove( idx_tmp_path );
+         return false;
+      }
+      // the index going live is what makes the new generation complete
+      fc::rename( idx_tmp_path, idx_path );
+      if( _writer_segment && *_writer_segment == segment_num )
+         close_writer();
+      std::lock_guard<std::mutex> segments_guard( _segments_mutex );
+      _segments[segment_num] = std::make_shared<segment_files>( generation, log_path, idx_path );
+   }
+
+   // the old generation is only removed once the rename that replaces it is on disk
+   detail::sync_to_disk( _dir );
+
+   // readers still holding the old generation keep their mappings of the unlinked files
+   try
+   {
+      fc::remove( segment->log.path() );
+      fc::remove( segment->idx.path() );
+   }
+   catch( const fc::exception& e )
+   {
+      wlog( "Could not remove old block log segment files, they will be removed on the next start: ${e}",
+            ("e", e.to_detail_string()) );
+   }
+   ilog( "Compacted block log segment ${s}, dropped ${n} bytes", ("s", segment_num)("n", log_size - live_bytes) );
+   return true;
+} FC_CAPTURE_AND_RETHROW( (segment_num) ) }
+
+} }
@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/signature_cache.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace graphene { namespace chain {
+
+signature_cache& signature_cache::instance()
+{
+   static signature_cache cache;
+   return cache;
+}
+
+size_t signature_cache::key_hash::operator()( const key_type& key )const
+{
+   // digest and signature are both uniformly distributed, the first byte of a signature is its recovery id
+   uint64_t signature_bits;
+   std::memcpy( &signature_bits, key.second.begin() + 1, sizeof(signature_bits) );
+   return key.first._hash[0] ^ signature_bits;
+}
+
+public_key_type signature_cache::recover( const digest_type& digest, const signature_type& signature )
+{
+   const key_type key( digest, signature );
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto itr = _current.find( key );
+      if( itr != _current.end() )
+      {
+         ++_hits;
+         return itr->second;
+      }
+      itr = _previous.find( key );
+      if( itr != _previous.end() )
+      {
+         ++_hits;
+         const public_key_type result = itr->second;
+         insert( key, result );
+         return result;
+      }
+   }
+
+   ++_misses;
+   const public_key_type result = fc::ecc::public_key( signature, digest );
+   std::lock_guard<std::mutex> lock( _mutex );
+   insert( key, result );
+   return result;
+}
+
+void signature_cache::insert( const key_type& key, const public_key_type& value )
+{
+   if( _capacity == 0 )
+      return;
+   if( _current.size() >= std::max<size_t>( _capacity / 2, 1 ) )
+   {
+      _previous = std::move( _current );
+      _current.clear();
+   }
+   _current.emplace( key, value );
+}
+
+void signature_cache::set_capacity( size_t capacity )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   _capacity = capacity;
+   _current.clear();
+   _previous.clear();
+}
+
+signature_cache_stats signature_cache::get_stats()const
+{
+   signature_cache_stats result;
+   result.hits = _hits;
+   result.misses = _misses;
+   std::lock_guard<std::mutex> lock( _mutex );
+   result.entries = _current.size() + _previous.size();
+   result.capacity = _capacity;
+   return result;
+}
+
+void signature_cache::clear()
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   _current.clear();
+   _previous.clear();
+   _hits = 0;
+   _misses = 0;
+}
+
+} } // graphene::chain
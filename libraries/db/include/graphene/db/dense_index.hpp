@@ -0,0 +1,102 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <graphene/db/generic_index.hpp>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  A generic_index for object types whose instances are dense and rarely removed, such as accounts and their
+    *  balances. The multi_index container still owns the objects and keeps all of its views, but the index also
+    *  keeps a pointer to every object in a vector addressed by instance number. find(), and with it get() and
+    *  object_database::find_object(), is then a bounds check and a load instead of a walk down the by_id tree.
+    *
+    *  The vector grows to the highest instance, so this only suits types whose ids come from create().
+    */
+   template<typename ObjectType, typename MultiIndexType, typename Allocator = std::allocator<ObjectType>>
+   class dense_index : public generic_index<ObjectType, MultiIndexType, Allocator>
+   {
+         typedef generic_index<ObjectType, MultiIndexType, Allocator> base_type;
+
+      public:
+         virtual const object& insert( object&& obj )override
+         {
+            const object& result = base_type::insert( std::move( obj ) );
+            set_slot( result.id, &result );
+            return result;
+         }
+
+         virtual const object& create( const std::function<void(object&)>& constructor )override
+         {
+            const object& result = base_type::create( constructor );
+            set_slot( result.id, &result );
+            return result;
+         }
+
+         virtual void modify( const object& obj, const std::function<void(object&)>& m )override
+         {
+            const object_id_type id = obj.id;
+            try {
+               base_type::modify( obj, m );
+            } catch( ... ) {
+               // multi_index drops an object whose change violated a constraint
+               if( base_type::find( id ) == nullptr )
+                  set_slot( id, nullptr );
+               throw;
+            }
+         }
+
+         virtual void remove( const object& obj )override
+         {
+            const object_id_type id = obj.id;
+            base_type::remove( obj );
+            set_slot( id, nullptr );
+         }
+
+         virtual const object* find( object_id_type id )const override
+         {
+            if( id.space_type() != ( uint16_t( ObjectType::space_id ) << 8 | ObjectType::type_id ) )
+               return nullptr;
+            const uint64_t instance = id.instance();
+            return instance < _objects.size() ? _objects[instance] : nullptr;
+         }
+
+      private:
+         void set_slot( object_id_type id, const object* obj )
+         {
+            const uint64_t instance = id.instance();
+            if( instance >= _objects.size() )
+            {
+               if( obj == nullptr )
+                  return;
+               _objects.resize( instance + 1, nullptr );
+            }
+            _objects[instance] = obj;
+         }
+
+         vector<const object*> _objects;
+   };
+
+} }
@@ -23,6 +23,7 @@
  */
 #pragma once
 #include <graphene/db/index.hpp>
+#include <graphene/db/node_pool.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
@@ -34,18 +35,34 @@ namespace graphene { namespace chain {
    using namespace boost::multi_index;
 
    struct by_id{};
+
+   /** The multi_index_container MultiIndexType with its allocator replaced by Allocator */
+   template<typename MultiIndexType, typename Allocator>
+   struct multi_index_with_allocator;
+   template<typename Value, typename IndexSpecifierList, typename OldAllocator, typename Allocator>
+   struct multi_index_with_allocator< multi_index_container<Value, IndexSpecifierList, OldAllocator>, Allocator >
+   {
+      typedef multi_index_container<Value, IndexSpecifierList, Allocator> type;
+   };
+
    /**
     *  Almost all objects can be tracked and managed via a boost::multi_index container that uses
     *  an unordered_unique key on the object ID.  This template class adapts the generic index interface
     *  to work with arbitrary boost multi_index containers on the same type.
+    *
+    *  With Allocator set to node_pool_allocator<ObjectType>, the container's nodes come from a node_pool owned
+    *  by the index, which suits indices whose objects are created and removed all the time.
     */
-   template<typename ObjectType, typename MultiIndexType>
+   template<typename ObjectType, typename MultiIndexType, typename Allocator = std::allocator<ObjectType>>
    class generic_index : public index
    {
       public:
-         typedef MultiIndexType index_type;
+         typedef typename multi_index_with_allocator<MultiIndexType, Allocator>::type index_type;
          typedef ObjectType     object_type;
 
+         generic_index()
+         :_indices( typename index_type::ctor_args_list(), graphene::db::index_allocator<Allocator>::make( _pool ) ){}
+
          virtual const object& insert( object&& obj )override
          {
             assert( nullptr != dynamic_cast<ObjectType*>(&obj) );
@@ -112,6 +129,8 @@ namespace graphene { namespace chain {
 
          const index_type& indices()const { return _indices; }
 
+         virtual node_pool_stats get_pool_stats()const override { return _pool.stats(); }
+
          virtual fc::uint128 hash()const override {
             fc::uint128 result;
             for( const auto& ptr : _indices )
@@ -123,7 +142,8 @@ namespace graphene { namespace chain {
          }
 
       private:
-         fc::uint128 _current_hash;
+         /** declared before _indices, which returns its nodes on destruction */
+         node_pool   _pool;
          index_type  _indices;
    };
 
@@ -0,0 +1,206 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <graphene/db/object_id.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   namespace detail {
+      inline object_id_type&       table_entry_id( object_id_type& e )       { return e; }
+      inline const object_id_type& table_entry_id( const object_id_type& e ) { return e; }
+      template<typename V>
+      object_id_type&              table_entry_id( std::pair<object_id_type,V>& e )       { return e.first; }
+      template<typename V>
+      const object_id_type&        table_entry_id( const std::pair<object_id_type,V>& e ) { return e.first; }
+   }
+
+   /**
+    * @class id_table
+    * @brief Open-addressing hash table keyed by object id, the entries live in one flat vector
+    *
+    * Entry is either object_id_type, making this a set, or a pair of an id and a value, making it a map; either
+    * should be cheap to copy. Probing is linear and erase shifts the following entries back, so there are no
+    * tombstones. Inserting and erasing invalidate iterators.
+    */
+   template<typename Entry>
+   class id_table
+   {
+      public:
+         typedef Entry value_type;
+
+         class const_iterator
+         {
+            public:
+               const_iterator( const Entry* pos, const Entry* end ):_pos(pos),_end(end) { skip_empty(); }
+
+               const Entry& operator*()const  { return *_pos; }
+               const Entry* operator->()const { return _pos; }
+               const_iterator& operator++()   { ++_pos; skip_empty(); return *this; }
+               bool operator == ( const const_iterator& other )const { return _pos == other._pos; }
+               bool operator != ( const const_iterator& other )const { return _pos != other._pos; }
+
+            private:
+               void skip_empty() { while( _pos != _end && is_empty( *_pos ) ) ++_pos; }
+
+               const Entry* _pos;
+               const Entry* _end;
+         };
+
+         const_iterator begin()const { return const_iterator( _slots.data(), _slots.data() + _slots.size() ); }
+         const_iterator end()const   { return const_iterator( _slots.data() + _slots.size(), _slots.data() + _slots.size() ); }
+
+         size_t size()const  { return _size; }
+         bool   empty()const { return _size == 0; }
+
+         const_iterator find( object_id_type id )const
+         {
+            if( _size == 0 )
+               return end();
+            for( size_t i = slot_of( id ); ; i = ( i + 1 ) & _mask )
+            {
+               if( detail::table_entry_id( _slots[i] ) == id )
+                  return const_iterator( &_slots[i], _slots.data() + _slots.size() );
+               if( is_empty( _slots[i] ) )
+                  return end();
+            }
+         }
+         size_t count( object_id_type id )const { return find( id ) != end() ? 1 : 0; }
+
+         /** @return false if an entry with the same id was already there, it is left unchanged */
+         bool insert( const Entry& entry )
+         {
+            Entry& slot = find_or_allocate( detail::table_entry_id( entry ) );
+            if( !is_empty( slot ) )
+               return false;
+            slot = entry;
+            ++_size;
+            return true;
+         }
+
+         /** For maps: the value stored for id, default constructed if there was none */
+         template<typename E = Entry>
+         typename E::second_type& operator[]( object_id_type id )
+         {
+            Entry& slot = find_or_allocate( id );
+            if( is_empty( slot ) )
+            {
+               slot = Entry();
+               detail::table_entry_id( slot ) = id;
+               ++_size;
+            }
+            return slot.second;
+         }
+
+         size_t erase( object_id_type id )
+         {
+            if( _size == 0 )
+               return 0;
+            size_t hole = slot_of( id );
+            while( detail::table_entry_id( _slots[hole] ) != id )
+            {
+               if( is_empty( _slots[hole] ) )
+                  return 0;
+               hole = ( hole + 1 ) & _mask;
+            }
+            // move back every following entry of the run that may sit in the hole, i.e. whose home slot is not
+            // between the hole and where it is now
+            for( size_t i = ( hole + 1 ) & _mask; !is_empty( _slots[i] ); i = ( i + 1 ) & _mask )
+            {
+               const size_t home = slot_of( detail::table_entry_id( _slots[i] ) );
+               if( ( ( i - home ) & _mask ) >= ( ( i - hole ) & _mask ) )
+               {
+                  _slots[hole] = _slots[i];
+                  hole = i;
+               }
+            }
+            _slots[hole] = empty_entry();
+            --_size;
+            return 1;
+         }
+
+         /** Removes every entry but keeps the memory */
+         void clear()
+         {
+            std::fill( _slots.begin(), _slots.end(), empty_entry() );
+            _size = 0;
+         }
+
+      private:
+         static object_id_type empty_id()
+         {
+            object_id_type id;
+            id.number = ~uint64_t(0);
+            return id;
+         }
+         static Entry empty_entry()
+         {
+            Entry e = Entry();
+            detail::table_entry_id( e ) = empty_id();
+            return e;
+         }
+         static bool is_empty( const Entry& e ) { return detail::table_entry_id( e ) == empty_id(); }
+
+         /** Fibonacci hashing, instances of one type are consecutive and would otherwise share low bits with others */
+         size_t slot_of( object_id_type id )const { return ( id.number * 0x9E3779B97F4A7C15ull ) >> _shift; }
+
+         Entry& find_or_allocate( object_id_type id )
+         {
+            if( ( _size + 1 ) * 4 > _slots.size() * 3 )
+               grow();
+            size_t i = slot_of( id );
+            while( !is_empty( _slots[i] ) && detail::table_entry_id( _slots[i] ) != id )
+               i = ( i + 1 ) & _mask;
+            return _slots[i];
+         }
+
+         void grow()
+         {
+            std::vector<Entry> old( std::max<size_t>( _slots.size() * 2, 16 ), empty_entry() );
+            old.swap( _slots );
+            _mask = _slots.size() - 1;
+            _shift = 64;
+            for( size_t n = _slots.size(); n > 1; n >>= 1 )
+               --_shift;
+            for( const Entry& e : old )
+               if( !is_empty( e ) )
+               {
+                  size_t i = slot_of( detail::table_entry_id( e ) );
+                  while( !is_empty( _slots[i] ) )
+                     i = ( i + 1 ) & _mask;
+                  _slots[i] = e;
+               }
+         }
+
+         std::vector<Entry> _slots;
+         size_t             _size  = 0;
+         size_t             _mask  = 0;
+         uint32_t           _shift = 64;
+   };
+
+} } // graphene::db
@@ -22,17 +22,23 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <graphene/db/node_pool.hpp>
 #include <graphene/db/object.hpp>
 #include <fc/interprocess/file_mapping.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/io/json.hpp>
 #include <fc/crypto/sha256.hpp>
 #include <fstream>
+#include <mutex>
 
 namespace graphene { namespace db {
    class object_database;
    using fc::path;
 
+   /** Start of an index file in the framed format, files from before it start with the next object id */
+   const uint64_t index_file_magic  = 0x4a424f4e45485047ull; // "GPHENOBJ"
+   const uint32_t index_file_format = 1;
+
    /**
     * @class index_observer
     * @brief used to get callbacks when objects change
@@ -78,6 +84,13 @@ namespace graphene { namespace db {
          virtual void           set_next_id( object_id_type id ) = 0;
 
          virtual const object&  load( const std::vector<char>& data ) = 0;
+         /**
+          *  Like load(), but replaces the object with the same id if there is one. Restoring saved state is
+          *  neither undoable nor reported to observers.
+          */
+         virtual const object&  restore( const std::vector<char>& data ) = 0;
+         /** Removes the object with id if there is one, without undo state or observer callbacks */
+         virtual void           restore_removed( object_id_type id ) = 0;
          /**
           *  Polymorphically insert by moving an object into the index.
           *  this should throw if the object is already in the database.
@@ -94,8 +107,18 @@ namespace graphene { namespace db {
           *  Opens the index loading objects from a file
           */
          virtual void open( const fc::path& db ) = 0;
+         /**
+          *  Reads and unpacks the objects saved in a file without touching the index, so different indices
+          *  can do this concurrently. The returned function inserts them and must run on the database's thread.
+          */
+         virtual std::function<void()> read_saved( const fc::path& db ) = 0;
          virtual void save( const fc::path& db ) = 0;
 
+         /**
+          *  @return a counter that every change to the objects or the next id bumps, a file saved
+          *  while the index was at some generation is current as long as the generation is the same
+          */
+         virtual uint64_t generation()const = 0;
 
 
          /** @return the object with id or nullptr if not found */
@@ -127,7 +150,17 @@ namespace graphene { namespace db {
          }
 
          virtual void               inspect_all_objects(std::function<void(const object&)> inspector)const = 0;
+         /**
+          * @return the sum of object::hash() over all objects, kept up to date as they change while hash tracking
+          * is on and computed by scan_hash() otherwise
+          */
          virtual fc::uint128        hash()const = 0;
+         /** @return hash() computed from scratch by visiting every object */
+         virtual fc::uint128        scan_hash()const = 0;
+         /** Tracking hash() costs every change an extra object::hash(), it is off by default */
+         virtual void               set_hash_tracking( bool track ) = 0;
+         /** @return the usage of the node pool the objects are allocated from, empty for indices without one */
+         virtual node_pool_stats    get_pool_stats()const { return node_pool_stats(); }
          virtual void               add_observer( const shared_ptr<index_observer>& ) = 0;
 
          virtual void               object_from_variant( const fc::variant& var, object& obj, uint32_t max_depth )const = 0;
@@ -164,6 +197,9 @@ namespace graphene { namespace db {
          /** called just after obj is modified */
          void on_modify( const object& obj );
 
+         /** held across every change, so read views on other threads never see one half done */
+         std::unique_lock<std::recursive_mutex> lock_views();
+
          template<typename T, typename... Args>
          T* add_secondary_index(Args... args)
          {
@@ -185,6 +221,7 @@ namespace graphene { namespace db {
       protected:
          vector< shared_ptr<index_observer> >   _observers;
          vector< unique_ptr<secondary_index> >  _sindex;
+         uint64_t                               _generation = 0;
 
       private:
          object_database& _db;
@@ -214,8 +251,19 @@ namespace graphene { namespace db {
          { return object_type::type_id; }
 
          virtual object_id_type get_next_id()const override              { return _next_id;    }
-         virtual void           use_next_id()override                    { ++_next_id.number;  }
-         virtual void           set_next_id( object_id_type id )override { _next_id = id;      }
+         virtual void           use_next_id()override                    { ++_next_id.number; ++_generation; }
+         virtual void           set_next_id( object_id_type id )override { _next_id = id; ++_generation;     }
+
+         virtual uint64_t       generation()const override               { return _generation; }
+         virtual fc::uint128    hash()const override                     { return _track_hash ? _hash : scan_hash(); }
+         virtual fc::uint128    scan_hash()const override                { return DerivedIndex::hash(); }
+
+         virtual void set_hash_tracking( bool track )override
+         {
+            if( track && !_track_hash )
+               _hash = scan_hash();
+            _track_hash = track;
+         }
 
          fc::sha256 get_object_version()const
          {
@@ -225,52 +273,140 @@ namespace graphene { namespace db {
 
          virtual void open( const path& db )override
          { 
-            if( !fc::exists( db ) ) return;
+            read_saved( db )();
+         }
+
+         /**
+          *  Index files start with index_file_magic, index_file_format, the next id and get_object_version(),
+          *  followed by every object packed in place behind its uint32_t size. Files without the magic are
+          *  read in the older format of doubly packed objects.
+          */
+         virtual std::function<void()> read_saved( const path& db )override
+         {
+            if( !fc::exists( db ) ) return [](){};
             fc::file_mapping fm( db.generic_string().c_str(), fc::read_only );
             fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size(db) );
             fc::datastream<const char*> ds( (const char*)mr.get_address(), mr.get_size() );
             fc::sha256 open_ver;
+            object_id_type next_id;
 
-            fc::raw::unpack(ds, _next_id);
+            uint64_t magic = 0;
+            if( ds.remaining() >= sizeof(magic) )
+               fc::raw::unpack(ds, magic);
+            const bool framed = magic == index_file_magic;
+            if( framed )
+            {
+               uint32_t format = 0;
+               fc::raw::unpack(ds, format);
+               FC_ASSERT( format == index_file_format, "Unknown index file format ${f} in ${db}", ("f",format)("db",db) );
+            }
+            else
+               ds = fc::datastream<const char*>( (const char*)mr.get_address(), mr.get_size() );
+
+            fc::raw::unpack(ds, next_id);
             fc::raw::unpack(ds, open_ver);
             FC_ASSERT( open_ver == get_object_version(), "Incompatible Version, the serialization of objects in this index has changed" );
-            try {
-               vector<char> tmp;
-               while( true ) 
+            auto objects = std::make_shared< vector<object_type> >();
+            if( framed )
+            {
+               while( ds.remaining() > 0 )
                {
-                  fc::raw::unpack( ds, tmp );
-                  load( tmp );
+                  uint32_t size = 0;
+                  fc::raw::unpack( ds, size );
+                  FC_ASSERT( ds.remaining() >= size, "Truncated object in ${db}", ("db",db) );
+                  fc::datastream<const char*> object_ds( ds.pos(), size );
+                  objects->emplace_back();
+                  fc::raw::unpack( object_ds, objects->back() );
+                  ds.skip( size );
                }
-            } catch ( const fc::exception&  ){}
+            }
+            else
+            {
+               try {
+                  vector<char> tmp;
+                  while( true ) 
+                  {
+                     fc::raw::unpack( ds, tmp );
+                     objects->push_back( fc::raw::unpack<object_type>( tmp ) );
+                  }
+               } catch ( const fc::exception&  ){}
+            }
+
+            return [this, next_id, objects]() {
+               _next_id = next_id;
+               for( auto& obj : *objects )
+                  insert_loaded( std::move( obj ) );
+            };
          }
 
          virtual void save( const path& db ) override 
          {
-            std::ofstream out( db.generic_string(), 
-                               std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+            // declared before the stream, which flushes into it on destruction
+            std::vector<char> buffer( 1 << 20 );
+            std::ofstream out;
+            out.rdbuf()->pubsetbuf( buffer.data(), buffer.size() );
+            out.open( db.generic_string(), std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
             FC_ASSERT( out );
-            auto ver  = get_object_version();
+            fc::raw::pack( out, index_file_magic );
+            fc::raw::pack( out, index_file_format );
             fc::raw::pack( out, _next_id );
-            fc::raw::pack( out, ver );
+            fc::raw::pack( out, get_object_version() );
             this->inspect_all_objects( [&]( const object& o ) {
-                auto vec = fc::raw::pack( static_cast<const object_type&>(o) );
-                auto packed_vec = fc::raw::pack( vec );
-                out.write( packed_vec.data(), packed_vec.size() );
+                const auto& obj = static_cast<const object_type&>(o);
+                const uint32_t size = fc::raw::pack_size( obj );
+                fc::raw::pack( out, size );
+                fc::raw::pack( out, obj );
             });
+            out.flush();
+            FC_ASSERT( out, "Failed to write ${db}", ("db",db) );
          }
 
          virtual const object&  load( const std::vector<char>& data )override
          {
-            const auto& result = DerivedIndex::insert( fc::raw::unpack<object_type>( data ) );
+            return insert_loaded( fc::raw::unpack<object_type>( data ) );
+         }
+
+         virtual const object&  restore( const std::vector<char>& data )override
+         {
+            auto obj = fc::raw::unpack<object_type>( data );
+            const object* existing = DerivedIndex::find( obj.id );
+            if( existing == nullptr )
+            {
+               ++_generation;
+               return insert_loaded( std::move( obj ) );
+            }
             for( const auto& item : _sindex )
-               item->object_inserted( result );
-            return result;
+               item->about_to_modify( *existing );
+            if( _track_hash )
+               _hash -= existing->hash();
+            DerivedIndex::modify( *existing, [&obj]( object& o ) { o.move_from( obj ); } );
+            if( _track_hash )
+               _hash += existing->hash();
+            for( const auto& item : _sindex )
+               item->object_modified( *existing );
+            ++_generation;
+            return *existing;
+         }
+
+         virtual void restore_removed( object_id_type id )override
+         {
+            const object* existing = DerivedIndex::find( id );
+            if( existing == nullptr ) return;
+            for( const auto& item : _sindex )
+               item->object_removed( *existing );
+            if( _track_hash )
+               _hash -= existing->hash();
+            DerivedIndex::remove( *existing );
+            ++_generation;
          }
 
 
          virtual const object&  create(const std::function<void(object&)>& constructor )override
          {
+            auto lock = lock_views();
             const auto& result = DerivedIndex::create( constructor );
+            if( _track_hash )
+               _hash += result.hash();
             for( const auto& item : _sindex )
                item->object_inserted( result );
             on_add( result );
@@ -279,7 +415,10 @@ namespace graphene { namespace db {
 
          virtual const object& insert( object&& obj ) override
          {
+            auto lock = lock_views();
             const auto& result = DerivedIndex::insert( std::move( obj ) );
+            if( _track_hash )
+               _hash += result.hash();
             for( const auto& item : _sindex )
                item->object_inserted( result );
             on_add( result );
@@ -288,18 +427,35 @@ namespace graphene { namespace db {
 
          virtual void  remove( const object& obj ) override
          {
+            auto lock = lock_views();
             for( const auto& item : _sindex )
                item->object_removed( obj );
             on_remove(obj);
+            if( _track_hash )
+               _hash -= obj.hash();
             DerivedIndex::remove(obj);
          }
 
          virtual void modify( const object& obj, const std::function<void(object&)>& m )override
          {
+            auto lock = lock_views();
             save_undo( obj );
             for( const auto& item : _sindex )
                item->about_to_modify( obj );
-            DerivedIndex::modify( obj, m );
+            const object_id_type id = obj.id;
+            if( _track_hash )
+               _hash -= obj.hash();
+            try {
+               DerivedIndex::modify( obj, m );
+            } catch( ... ) {
+               // the object may have changed anyway, or been dropped for violating a constraint
+               const object* after = DerivedIndex::find( id );
+               if( _track_hash && after != nullptr )
+                  _hash += after->hash();
+               throw;
+            }
+            if( _track_hash )
+               _hash += obj.hash();
             for( const auto& item : _sindex )
                item->object_modified( obj );
             on_modify( obj );
@@ -329,7 +485,21 @@ namespace graphene { namespace db {
          }
 
       private:
+         /** inserts an object read from disk, which is not an undoable change */
+         const object& insert_loaded( object_type&& obj )
+         {
+            const auto& result = DerivedIndex::insert( std::move( obj ) );
+            if( _track_hash )
+               _hash += result.hash();
+            for( const auto& item : _sindex )
+               item->object_inserted( result );
+            return result;
+         }
+
          object_id_type _next_id;
+         /** sum of the hashes of all objects, wrapping around, only current while _track_hash is set */
+         fc::uint128    _hash;
+         bool           _track_hash = false;
    };
 
 } } // graphene::db
@@ -0,0 +1,159 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <fc/reflect/reflect.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /** Usage of a node_pool */
+   struct node_pool_stats
+   {
+      /** bytes per node, 0 until the first node was allocated */
+      uint64_t node_size = 0;
+      uint64_t nodes_in_use = 0;
+      /** nodes freed and waiting on the free list */
+      uint64_t free_nodes = 0;
+      /** bytes held in slabs, whether in use or not */
+      uint64_t slab_bytes = 0;
+      /** nodes handed out since the pool was created */
+      uint64_t node_allocations = 0;
+      /** calls to the system allocator for slabs, the rest were served by the pool */
+      uint64_t slab_allocations = 0;
+   };
+
+   /**
+    * @class node_pool
+    * @brief Hands out equally sized nodes carved from slabs and recycles freed ones through a free list
+    *
+    * The node size is that of the first single object allocated, other sizes and arrays go to the system
+    * allocator. Slabs are only returned to the system when the pool is destroyed. Like the index that owns it,
+    * a pool must only be used from one thread at a time.
+    */
+   class node_pool
+   {
+      public:
+         static const size_t slab_size = 64 * 1024;
+
+         node_pool() = default;
+         node_pool( const node_pool& ) = delete;
+         node_pool& operator = ( const node_pool& ) = delete;
+         ~node_pool();
+
+         void* allocate( size_t size, size_t count );
+         void  deallocate( void* p, size_t size, size_t count );
+
+         const node_pool_stats& stats()const { return _stats; }
+
+      private:
+         void add_slab();
+
+         struct free_node { free_node* next; };
+
+         /** node size rounded up to keep every node aligned */
+         size_t             _stride = 0;
+         free_node*         _free = nullptr;
+         std::vector<char*> _slabs;
+         node_pool_stats    _stats;
+   };
+
+   /**
+    * Allocator that takes single objects from a node_pool, for a multi_index_container whose nodes should come
+    * from its index's pool. Without a pool it falls back to the system allocator.
+    */
+   template<typename T>
+   class node_pool_allocator
+   {
+      public:
+         typedef T                 value_type;
+         typedef T*                pointer;
+         typedef const T*          const_pointer;
+         typedef T&                reference;
+         typedef const T&          const_reference;
+         typedef std::size_t       size_type;
+         typedef std::ptrdiff_t    difference_type;
+
+         template<typename U>
+         struct rebind { typedef node_pool_allocator<U> other; };
+
+         explicit node_pool_allocator( node_pool* pool = nullptr ):_pool(pool){}
+         template<typename U>
+         node_pool_allocator( const node_pool_allocator<U>& other ):_pool(other.pool()){}
+
+         pointer allocate( size_type n, const void* = nullptr )
+         {
+            if( _pool == nullptr )
+               return static_cast<pointer>( ::operator new( n * sizeof(T) ) );
+            return static_cast<pointer>( _pool->allocate( sizeof(T), n ) );
+         }
+         void deallocate( pointer p, size_type n )
+         {
+            if( _pool == nullptr )
+               ::operator delete( p );
+            else
+               _pool->deallocate( p, sizeof(T), n );
+         }
+
+         template<typename U, typename... Args>
+         void construct( U* p, Args&&... args ) { ::new( (void*)p ) U( std::forward<Args>( args )... ); }
+         template<typename U>
+         void destroy( U* p ) { p->~U(); }
+
+         size_type max_size()const { return size_type(-1) / sizeof(T); }
+         pointer       address( reference r )const       { return &r; }
+         const_pointer address( const_reference r )const { return &r; }
+
+         node_pool* pool()const { return _pool; }
+
+         template<typename U>
+         bool operator == ( const node_pool_allocator<U>& other )const { return _pool == other.pool(); }
+         template<typename U>
+         bool operator != ( const node_pool_allocator<U>& other )const { return _pool != other.pool(); }
+
+      private:
+         node_pool* _pool;
+   };
+
+   /** Makes the allocator an index passes to its container, binding pool allocators to the index's pool */
+   template<typename Allocator>
+   struct index_allocator
+   {
+      static Allocator make( node_pool& ) { return Allocator(); }
+   };
+   template<typename T>
+   struct index_allocator< node_pool_allocator<T> >
+   {
+      static node_pool_allocator<T> make( node_pool& pool ) { return node_pool_allocator<T>( &pool ); }
+   };
+
+} } // graphene::db
+
+FC_REFLECT( graphene::db::node_pool_stats,
+            (node_size)(nodes_in_use)(free_nodes)(slab_bytes)(node_allocations)(slab_allocations) )
@@ -27,6 +27,9 @@
 #include <fc/crypto/city.hpp>
 #include <fc/uint128.hpp>
 
+#include <cstddef>
+#include <new>
+
 #define MAX_NESTING (200)
 
 namespace graphene { namespace db {
@@ -74,6 +77,9 @@ namespace graphene { namespace db {
 
          /// these methods are implemented for derived classes by inheriting abstract_object<DerivedClass>
          virtual unique_ptr<object> clone()const = 0;
+         /// size and placement copy for storage owned by the caller, which has to destroy the copy explicitly
+         virtual size_t             clone_size()const = 0;
+         virtual object*            clone_into( void* storage )const = 0;
          virtual void               move_from( object& obj ) = 0;
          virtual variant            to_variant()const  = 0;
          virtual vector<char>       pack()const = 0;
@@ -95,6 +101,12 @@ namespace graphene { namespace db {
          {
             return unique_ptr<object>(new DerivedClass( *static_cast<const DerivedClass*>(this) ));
          }
+         virtual size_t  clone_size()const { return sizeof(DerivedClass); }
+         virtual object* clone_into( void* storage )const
+         {
+            static_assert( alignof(DerivedClass) <= alignof(std::max_align_t), "storage is only aligned for max_align_t" );
+            return new (storage) DerivedClass( *static_cast<const DerivedClass*>(this) );
+         }
 
          virtual void    move_from( object& obj )
          {
@@ -24,14 +24,31 @@
 #pragma once
 #include <graphene/db/object.hpp>
 #include <graphene/db/index.hpp>
+#include <graphene/db/state_journal.hpp>
 #include <graphene/db/undo_database.hpp>
 
 #include <fc/log/logger.hpp>
+#include <fc/reflect/reflect.hpp>
 
+#include <atomic>
+#include <functional>
 #include <map>
+#include <mutex>
+#include <unordered_set>
 
 namespace graphene { namespace db {
 
+   class read_view;
+
+   /** The next id and index::hash() of one index, equal on nodes whose index holds the same objects */
+   struct index_hash
+   {
+      uint8_t        space = 0;
+      uint8_t        type = 0;
+      object_id_type next_id;
+      fc::uint128    hash;
+   };
+
    /**
     *   @class object_database
     *   @brief maintains a set of indexed objects that can be modified with multi-level rollback support
@@ -44,15 +61,79 @@ namespace graphene { namespace db {
 
          void reset_indexes() { _index.clear(); _index.resize(255); }
 
+         /**
+          * Reads the saved indices, the files are unpacked in parallel and inserted in index order. With the
+          * journal enabled, the journaled blocks up to the last irreversible one are applied on top.
+          */
          void open(const fc::path& data_dir );
 
          /**
-          * Saves the complete state of the object_database to disk, this could take a while
+          * Saves the complete state of the object_database to disk. Only indices that changed since they were
+          * last opened or saved are written, the files of the others are hard-linked from the previous save.
+          * The journal is emptied once the new state is in place.
           */
          void flush();
          void wipe(const fc::path& data_dir); // remove from disk
          void close();
 
+         /**
+          * Saves every index into dir in the layout flush() uses, without touching the data directory
+          * @return space and type of every index saved
+          */
+         vector< std::pair<uint8_t,uint8_t> > save_indices( const fc::path& dir );
+
+         /** @return a hash over get_index_hashes(), equal for equal object states */
+         fc::sha256 get_state_hash()const;
+         /**
+          * @return the hash of every index in order of space and type, the indices keep them current while state
+          * hash tracking is on and scan all their objects for them otherwise
+          */
+         vector<index_hash> get_index_hashes()const;
+         /** @return the state hash over index hashes taken from get_index_hashes() */
+         static fc::sha256 get_state_hash( const vector<index_hash>& index_hashes );
+         /** Turns index::set_hash_tracking() on or off for all indices, including the ones added later */
+         void set_state_hash_tracking( bool track );
+         bool state_hash_tracking()const { return _track_state_hashes; }
+
+         /**
+          * Keeps a journal of the state after every block in the data directory, so a process that exits without
+          * flush() reopens at its last irreversible block instead of at the last flush. Set before open().
+          */
+         void set_journal_enabled( bool enabled ) { _journal_enabled = enabled; }
+         bool journal_enabled()const { return _journal_enabled; }
+         /**
+          * Appends the objects changed since the previous call to the journal, call whenever the state is that
+          * of a complete block
+          */
+         void journal_commit( uint32_t block_num, uint32_t last_irreversible_block_num );
+         /**
+          * While suspended no changes are collected and journal_commit() writes nothing, for replays that would
+          * otherwise collect every object they touch. Resuming flushes the state, so the journal starts over on
+          * top of what was applied in the meantime.
+          */
+         void set_journal_suspended( bool suspended );
+         bool journal_suspended()const { return _journal_suspended; }
+
+         /**
+          * Runs task on the state as it was before the top undo_states undo states, then puts the current state back.
+          * Neither change is undoable or seen by read views, whose readers wait meanwhile. The objects put back are
+          * journaled again, so a task may flush.
+          */
+         void with_undo_states_rewound( size_t undo_states, const std::function<void()>& task );
+
+         /**
+          * Opens a read_view of the current state, for reading it from other threads while this one goes on
+          * changing it. Call from the thread that modifies the database, between changes.
+          */
+         std::shared_ptr<const read_view> open_read_view();
+
+         /** Sets how many threads open() and flush() use, 0 (the default) for one per core */
+         void set_io_threads( uint32_t num_threads ) { _io_threads = num_threads; }
+         /** node_pool usage of every index whose objects come from a pool, keyed by space and type */
+         std::map< std::pair<uint32_t,uint32_t>, node_pool_stats > get_pool_stats()const;
+         /** Time every index spent reading and inserting its objects during the last open(), keyed by space and type */
+         const std::map< std::pair<uint32_t,uint32_t>, fc::microseconds >& get_index_load_times()const { return _index_load_times; }
+
          template<typename T, typename F>
          const T& create( F&& constructor )
          {
@@ -135,6 +216,7 @@ namespace graphene { namespace db {
                 _index[ObjectType::space_id].resize( 255 );
             assert(!_index[ObjectType::space_id][ObjectType::type_id]);
             unique_ptr<index> indexptr( new IndexType(*this) );
+            indexptr->set_hash_tracking( _track_state_hashes );
             _index[ObjectType::space_id][ObjectType::type_id] = std::move(indexptr);
             return static_cast<IndexType*>(_index[ObjectType::space_id][ObjectType::type_id].get());
          }
@@ -166,14 +248,36 @@ namespace graphene { namespace db {
 
          friend class base_primary_index;
          friend class undo_database;
+         friend class read_view;
          void save_undo( const object& obj );
          void save_undo_add( const object& obj );
          void save_undo_remove( const object& obj );
+         /** @return a lock on _views_mutex while read views are open, held by indices for every change */
+         std::unique_lock<std::recursive_mutex> lock_views();
 
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+         /** index::generation() of every index as of its file in object_database/, keyed by space and type */
+         std::map< std::pair<uint32_t,uint32_t>, uint64_t >        _saved_generations;
+         uint32_t                                                  _io_threads = 0;
+         std::map< std::pair<uint32_t,uint32_t>, fc::microseconds > _index_load_times;
+
+         void open_journal();
+         bool                                                      _track_state_hashes = false;
+         bool                                                      _journal_enabled = false;
+         bool                                                      _journal_suspended = false;
+         /** written to object_database/journal_base by every flush, the journal only applies on top of it */
+         uint64_t                                                  _journal_base = 0;
+         state_journal                                             _journal;
+         /** objects created, modified or removed since the last journal record */
+         std::unordered_set< object_id_type >                      _journal_dirty;
+
+         /** guards _views and the index contents while views are open */
+         std::recursive_mutex                                      _views_mutex;
+         std::vector< read_view* >                                 _views;
+         std::atomic<size_t>                                       _open_views{0};
    };
 
 } } // graphene::db
 
-
+FC_REFLECT( graphene::db::index_hash, (space)(type)(next_id)(hash) )
@@ -0,0 +1,181 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <graphene/db/object_database.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/optional.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /**
+    * @class read_view
+    * @brief A consistent view of the object_database as of the moment it was opened, readable from any thread
+    *
+    * While views are open the object_database keeps, per view, a copy of every object as it was before its first
+    * change after the view opened, and remembers the objects created since. Reads return copies taken under the
+    * database's view lock, which readers hold for one object or one batch of objects at a time and writers for the
+    * duration of a single change, so neither side waits long on the other. Open views with
+    * object_database::open_read_view() from the thread that modifies the database, and close them soon: the
+    * preserved copies grow with every change made while they are open.
+    */
+   class read_view
+   {
+      public:
+         explicit read_view( object_database& db );
+         ~read_view();
+
+         read_view( const read_view& ) = delete;
+         read_view& operator=( const read_view& ) = delete;
+
+         /** @return a copy of the object as of the view, null if it did not exist */
+         std::shared_ptr<const object> find_object( object_id_type id )const;
+
+         /**
+          * @return copies of all objects of an index as of the view, in no particular order. The index is read by
+          * instance in batches of batch_size ids, so prefer get_range() for indices with many removed objects.
+          */
+         std::vector< std::shared_ptr<const object> > get_objects( uint8_t space_id, uint8_t type_id )const;
+
+         template<typename T>
+         fc::optional<T> find( object_id_type id )const
+         {
+            auto obj = find_object( id );
+            if( !obj )
+               return fc::optional<T>();
+            assert( nullptr != dynamic_cast<const T*>( obj.get() ) );
+            return static_cast<const T&>( *obj );
+         }
+
+         template<typename T>
+         T get( object_id_type id )const
+         {
+            auto obj = find<T>( id );
+            FC_ASSERT( obj.valid(), "Unable to find Object", ("id",id) );
+            return std::move( *obj );
+         }
+
+         template<uint8_t SpaceID, uint8_t TypeID, typename T>
+         fc::optional<T> find( object_id<SpaceID,TypeID,T> id )const { return find<T>( id ); }
+
+         template<uint8_t SpaceID, uint8_t TypeID, typename T>
+         T get( object_id<SpaceID,TypeID,T> id )const { return get<T>( id ); }
+
+         /** @return copies of all objects of type T as of the view, in no particular order */
+         template<typename T>
+         std::vector<T> get_all()const
+         {
+            std::vector<T> result;
+            for( const auto& obj : get_objects( T::space_id, T::type_id ) )
+               result.push_back( static_cast<const T&>( *obj ) );
+            return result;
+         }
+
+         /**
+          * @return copies of the objects of IndexType whose Tag keys lie between lower_bound( lower ) and
+          * upper_bound( upper ) as of the view, in the order of Tag. Tag must be an ordered_unique index. The live
+          * index is walked batch_size objects at a time, each batch under the view lock, and every batch resumes
+          * after the key of the last object read. An object read from the live index was unchanged since the view
+          * opened, so a preserved copy of it from a later change is not added again.
+          */
+         template<typename IndexType, typename Tag, typename Lower, typename Upper>
+         std::vector<typename IndexType::object_type> get_range( const Lower& lower, const Upper& upper )const
+         {
+            typedef typename IndexType::object_type object_type;
+            const auto& idx = _db.get_index_type<IndexType>().indices().template get<Tag>();
+            std::vector<object_type> result;
+            std::unordered_set<object_id_type> read_live;
+
+            std::unique_lock<std::recursive_mutex> lock( _db._views_mutex );
+            auto itr = idx.lower_bound( lower );
+            while( true )
+            {
+               const auto end = idx.upper_bound( upper );
+               for( size_t n = 0; itr != end && n < batch_size; ++itr, ++n )
+                  if( _preserved.find( itr->id ) == _preserved.end() )
+                  {
+                     result.push_back( *itr );
+                     read_live.insert( itr->id );
+                  }
+               if( itr == end )
+                  break;
+               const object_type last = *std::prev( itr );
+               lock.unlock();
+               if( _batch_observer )
+                  _batch_observer();
+               lock.lock();
+               itr = idx.upper_bound( idx.key_extractor()( last ) );
+            }
+
+            // objects changed or removed since the view opened are found by their key as of the view
+            for( const auto& item : _preserved )
+            {
+               if( !item.second || item.first.space() != object_type::space_id || item.first.type() != object_type::type_id
+                   || read_live.count( item.first ) )
+                  continue;
+               const auto& obj = static_cast<const object_type&>( *item.second );
+               const auto key = idx.key_extractor()( obj );
+               if( !idx.key_comp()( key, lower ) && !idx.key_comp()( upper, key ) )
+                  result.push_back( obj );
+            }
+            lock.unlock();
+
+            const auto comp = idx.value_comp();
+            std::sort( result.begin(), result.end(), [&comp]( const object_type& a, const object_type& b ) {
+               return comp( a, b );
+            });
+            return result;
+         }
+
+         /** objects read per hold of the view lock by get_objects() and get_range() */
+         static const size_t batch_size = 1000;
+
+         /** Sets a function called without the view lock between the batches of get_objects() and get_range() */
+         void set_batch_observer( std::function<void()> observer ) { _batch_observer = std::move( observer ); }
+
+      private:
+         friend class object_database;
+
+         /** called with the view lock held, just before obj changes or is removed */
+         void preserve( const object& obj );
+         /** called with the view lock held, just after obj was created */
+         void preserve_absent( const object& obj );
+
+         object_database& _db;
+         /** objects as of the view, null for those created after it opened */
+         std::unordered_map< object_id_type, std::shared_ptr<const object> > _preserved;
+         std::function<void()>                                                _batch_observer;
+   };
+
+} } // graphene::db
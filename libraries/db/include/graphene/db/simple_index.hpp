@@ -101,7 +101,8 @@ namespace graphene { namespace db {
          virtual fc::uint128 hash()const override {
             fc::uint128 result;
             for( const auto& ptr : _objects )
-               result += ptr->hash();
+               if( ptr.get() )
+                  result += ptr->hash();
 
             return result;
          }
@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <graphene/db/object_id.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <fstream>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /**
+    * The objects a block left behind: the current value of every object created or modified since the previous
+    * record, the ids of those removed since, and the next id of every index.
+    */
+   struct journal_record
+   {
+      uint32_t                                                      block_num = 0;
+      uint32_t                                                      last_irreversible_block_num = 0;
+      std::vector< object_id_type >                                 next_ids;
+      std::vector< std::pair< object_id_type, std::vector<char> > > objects;
+      std::vector< object_id_type >                                 removed;
+   };
+
+   /** Where a record ends in the journal file, and the blocks it was written for */
+   struct journal_position
+   {
+      uint32_t block_num = 0;
+      uint32_t last_irreversible_block_num = 0;
+      uint64_t end = 0;
+   };
+
+   /**
+    * @class state_journal
+    * @brief Append-only file of journal_records written on top of the last saved object_database
+    *
+    * The file starts with a magic number and the base, a number flush() writes along with the index files, so a
+    * journal is only ever applied to the state it was written on. Every record is framed by its size and a
+    * checksum, reading stops at the first record that was not written completely. Records are read one at a time,
+    * so the journal never has to fit in memory.
+    */
+   class state_journal
+   {
+      public:
+         ~state_journal() { close(); }
+
+         /**
+          * Checks the records of file if it was written on top of base, without unpacking their objects
+          * @return the position of every complete record
+          */
+         static std::vector< journal_position > scan( const fc::path& file, uint64_t base );
+         /** Unpacks the records of file that end at or before end, one at a time, and passes them to apply */
+         static void read( const fc::path& file, uint64_t base, uint64_t end,
+                           const std::function<void(const journal_record&)>& apply );
+
+         /**
+          * Opens file for appending. The first keep_size bytes are kept, they must hold records read() returned
+          * for the same base; with keep_size 0 the file is started over for base.
+          */
+         void open( const fc::path& file, uint64_t base, uint64_t keep_size = 0 );
+         void close();
+         bool is_open()const { return _out.is_open(); }
+
+         /** Appends record, it is handed to the operating system before this returns */
+         void append( const journal_record& record );
+         /** Drops every record, the journal then applies on top of base */
+         void reset( uint64_t base );
+
+      private:
+         /**
+          * Calls f( data, end ) with the packed bytes and the end of every complete record of file, up to end.
+          * @return the end of the last complete record, 0 if the file does not hold a journal for base
+          */
+         static uint64_t for_each_record( const fc::path& file, uint64_t base, uint64_t end,
+                                          const std::function<void(const std::vector<char>&, uint64_t)>& f );
+
+         fc::path      _file;
+         std::ofstream _out;
+   };
+
+} } // graphene::db
+
+FC_REFLECT( graphene::db::journal_record, (block_num)(last_irreversible_block_num)(next_ids)(objects)(removed) )
+FC_REFLECT( graphene::db::journal_position, (block_num)(last_irreversible_block_num)(end) )
@@ -0,0 +1,86 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#include <graphene/db/object.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /**
+    * @class slab_pool
+    * @brief Keeps the slabs of dropped undo states for the next ones, so steady block processing stops allocating
+    */
+   class slab_pool
+   {
+      public:
+         static const size_t slab_size = 64 * 1024;
+         /** slabs beyond this many are freed instead of kept */
+         static const size_t max_free_slabs = 256;
+
+         std::unique_ptr<char[]> acquire();
+         void                    release( std::unique_ptr<char[]>&& slab );
+         size_t                  free_slabs()const { return _free.size(); }
+
+      private:
+         std::vector< std::unique_ptr<char[]> > _free;
+   };
+
+   /**
+    * @class undo_arena
+    * @brief Holds the object copies of one undo state in slabs instead of one heap allocation each
+    *
+    * The copies are destroyed and the slabs go back to the pool when the arena is cleared or destroyed.
+    */
+   class undo_arena
+   {
+      public:
+         explicit undo_arena( slab_pool* pool = nullptr ):_pool(pool){}
+         undo_arena( undo_arena&& other );
+         undo_arena& operator = ( undo_arena&& other );
+         undo_arena( const undo_arena& ) = delete;
+         undo_arena& operator = ( const undo_arena& ) = delete;
+         ~undo_arena() { clear(); }
+
+         /** @return a copy of obj that lives as long as the arena */
+         object* clone( const object& obj );
+         /** Takes over the copies and slabs of other, which is left empty, e.g. when undo states are merged */
+         void    absorb( undo_arena& other );
+         void    clear();
+
+         size_t  object_count()const { return _objects.size(); }
+
+      private:
+         slab_pool*                             _pool;
+         std::vector< std::unique_ptr<char[]> > _slabs;
+         /** bytes handed out from _slabs.back() */
+         size_t                                 _used = 0;
+         /** allocations too large for a slab, these are not pooled */
+         std::vector< std::unique_ptr<char[]> > _large;
+         std::vector< object* >                 _objects;
+   };
+
+} } // graphene::db
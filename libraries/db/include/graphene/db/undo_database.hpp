@@ -22,8 +22,11 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <graphene/db/id_table.hpp>
 #include <graphene/db/object.hpp>
+#include <graphene/db/undo_arena.hpp>
 #include <deque>
+#include <map>
 #include <fc/exception/exception.hpp>
 
 namespace graphene { namespace db {
@@ -32,12 +35,19 @@ namespace graphene { namespace db {
    using fc::flat_set;
    class object_database;
 
+   /**
+    * The changes of one session. The objects in old_values and removed are copies kept in arena, they stay
+    * valid as long as the state.
+    */
    struct undo_state
    {
-      unordered_map<object_id_type, unique_ptr<object> > old_values;
-      unordered_map<object_id_type, object_id_type>      old_index_next_ids;
-      std::unordered_set<object_id_type>                 new_ids;
-      unordered_map<object_id_type, unique_ptr<object> > removed;
+      explicit undo_state( slab_pool* pool = nullptr ):arena(pool){}
+
+      id_table< std::pair<object_id_type, object*> >        old_values;
+      id_table< std::pair<object_id_type, object_id_type> > old_index_next_ids;
+      id_table< object_id_type >                            new_ids;
+      id_table< std::pair<object_id_type, object*> >        removed;
+      undo_arena                                            arena;
    };
 
 
@@ -127,11 +137,24 @@ namespace graphene { namespace db {
          void pop_commit();
 
          std::size_t size()const { return _stack.size(); }
+         /** slabs of dropped states waiting to be reused */
+         std::size_t free_slabs()const { return _slabs.free_slabs(); }
          void set_max_size(size_t new_max_size) { _max_size = new_max_size; }
          size_t max_size()const { return _max_size; }
 
          const undo_state& head()const;
 
+         /** What the top states changed, as it was before them */
+         struct prior_state
+         {
+            /** every object the states created, changed or removed, null for those they created */
+            std::map< object_id_type, const object* >                     objects;
+            /** the next ids of the indices the states created objects in, keyed by space and type */
+            std::map< std::pair<uint8_t,uint8_t>, object_id_type >        next_ids;
+         };
+         /** @return the state before the top count states, valid as long as they are */
+         prior_state state_before( size_t count )const;
+
       private:
          void undo();
          void merge();
@@ -139,6 +162,8 @@ namespace graphene { namespace db {
 
          uint32_t                _active_sessions = 0;
          bool                    _disabled = true;
+         /** declared before _stack, whose states return their slabs here when destroyed */
+         slab_pool               _slabs;
          std::deque<undo_state>  _stack;
          object_database&        _db;
          size_t                  _max_size = 256;
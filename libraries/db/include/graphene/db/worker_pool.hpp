@@ -0,0 +1,61 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace fc { class thread; }
+
+namespace graphene { namespace db {
+
+   /**
+    * @class worker_pool
+    * @brief A fixed set of fc threads for splitting independent pieces of work
+    *
+    * run() hands out task indices to the threads one at a time, so uneven tasks still balance out, and
+    * blocks the calling thread until all of them are done.
+    */
+   class worker_pool
+   {
+      public:
+         /** @param num_threads how many threads to start, 0 for one per core */
+         explicit worker_pool( uint32_t num_threads = 0 );
+         ~worker_pool();
+
+         uint32_t size()const { return _threads.size(); }
+
+         /**
+          * Calls task(i) for every i in [0, count) on the pool's threads and waits for all of them. A thread whose
+          * task throws takes no further tasks, the first exception is rethrown once every thread is done.
+          */
+         void run( size_t count, const std::function<void(size_t)>& task );
+
+      private:
+         std::vector< std::unique_ptr<fc::thread> > _threads;
+   };
+
+} } // graphene::db
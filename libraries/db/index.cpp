@@ -31,13 +31,17 @@ namespace graphene { namespace db {
 
    void base_primary_index::on_add( const object& obj )
    {
+      ++_generation;
       _db.save_undo_add( obj );
       for( auto ob : _observers ) ob->on_add( obj );
    }
 
    void base_primary_index::on_remove( const object& obj )
-   { _db.save_undo_remove( obj ); for( auto ob : _observers ) ob->on_remove( obj ); }
+   { ++_generation; _db.save_undo_remove( obj ); for( auto ob : _observers ) ob->on_remove( obj ); }
 
    void base_primary_index::on_modify( const object& obj )
-   {for( auto ob : _observers ) ob->on_modify(  obj ); }
+   { ++_generation; for( auto ob : _observers ) ob->on_modify(  obj ); }
+
+   std::unique_lock<std::recursive_mutex> base_primary_index::lock_views()
+   { return _db.lock_views(); }
 } } // graphene::chain
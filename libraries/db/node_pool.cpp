@@ -0,0 +1,89 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/db/node_pool.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace db {
+
+node_pool::~node_pool()
+{
+   for( char* slab : _slabs )
+      ::operator delete( slab );
+}
+
+void* node_pool::allocate( size_t size, size_t count )
+{
+   if( _stride == 0 && count == 1 )
+   {
+      const size_t align = alignof(std::max_align_t);
+      _stride = std::max( ( size + align - 1 ) & ~( align - 1 ), sizeof(free_node) );
+      _stats.node_size = size;
+   }
+   if( count != 1 || size != _stats.node_size )
+      return ::operator new( size * count );
+
+   if( _free == nullptr )
+      add_slab();
+   free_node* node = _free;
+   _free = node->next;
+   --_stats.free_nodes;
+   ++_stats.nodes_in_use;
+   ++_stats.node_allocations;
+   return node;
+}
+
+void node_pool::deallocate( void* p, size_t size, size_t count )
+{
+   if( count != 1 || size != _stats.node_size )
+   {
+      ::operator delete( p );
+      return;
+   }
+   free_node* node = static_cast<free_node*>( p );
+   node->next = _free;
+   _free = node;
+   ++_stats.free_nodes;
+   --_stats.nodes_in_use;
+}
+
+void node_pool::add_slab()
+{
+   const size_t nodes = std::max<size_t>( slab_size / _stride, 1 );
+   char* slab = static_cast<char*>( ::operator new( nodes * _stride ) );
+   _slabs.push_back( slab );
+   // thread the new nodes onto the free list in address order
+   for( size_t i = nodes; i > 0; --i )
+   {
+      free_node* node = reinterpret_cast<free_node*>( slab + ( i - 1 ) * _stride );
+      node->next = _free;
+      _free = node;
+   }
+   _stats.free_nodes += nodes;
+   _stats.slab_bytes += nodes * _stride;
+   ++_stats.slab_allocations;
+}
+
+} } // graphene::db
@@ -22,11 +22,16 @@
  * THE SOFTWARE.
  */
 #include <graphene/db/object_database.hpp>
+#include <graphene/db/read_view.hpp>
+#include <graphene/db/worker_pool.hpp>
 
 #include <fc/io/raw.hpp>
 #include <fc/container/flat.hpp>
 #include <fc/uint128.hpp>
 
+#include <algorithm>
+#include <fstream>
+
 namespace graphene { namespace db {
 
 object_database::object_database()
@@ -40,6 +45,7 @@ object_database::~object_database(){}
 
 void object_database::close()
 {
+   _journal.close();
 }
 
 const object* object_database::find_object( object_id_type id )const
@@ -71,47 +77,340 @@ index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
 void object_database::flush()
 {
 //   ilog("Save object_database in ${d}", ("d", _data_dir));
+   // links would fail on files left over from an interrupted flush
+   fc::remove_all( _data_dir / "object_database.tmp" );
    fc::create_directories( _data_dir / "object_database.tmp" / "lock" );
+   std::map< std::pair<uint32_t,uint32_t>, uint64_t > saved_generations;
+   vector< std::pair< index*, fc::path > > to_save;
    for( uint32_t space = 0; space < _index.size(); ++space )
    {
       fc::create_directories( _data_dir / "object_database.tmp" / fc::to_string(space) );
       const auto types = _index[space].size();
       for( uint32_t type = 0; type  <  types; ++type )
-         if( _index[space][type] )
-            _index[space][type]->save( _data_dir / "object_database.tmp" / fc::to_string(space)/fc::to_string(type) );
+      {
+         if( !_index[space][type] )
+            continue;
+         const auto key = std::make_pair( space, type );
+         const uint64_t generation = _index[space][type]->generation();
+         const fc::path file = _data_dir / "object_database.tmp" / fc::to_string(space)/fc::to_string(type);
+         const fc::path saved_file = _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type);
+         saved_generations[key] = generation;
+
+         auto saved = _saved_generations.find( key );
+         if( saved != _saved_generations.end() && saved->second == generation && fc::exists( saved_file ) )
+         {
+            try
+            {
+               // the old directory is deleted below, the link keeps the unchanged file alive
+               fc::create_hard_link( saved_file, file );
+               continue;
+            }
+            catch( const fc::exception& e )
+            {
+               wlog( "Unable to link ${f}, saving it again: ${e}", ("f", saved_file)("e", e.to_string()) );
+            }
+         }
+         to_save.emplace_back( _index[space][type].get(), file );
+      }
+   }
+   // saving only reads the index and writes its own file, so all of them can be saved at once
+   worker_pool( _io_threads ).run( to_save.size(), [&to_save]( size_t i ) {
+      to_save[i].first->save( to_save[i].second );
+   } );
+   // the time keeps bases unique even across wiped or replaced directories
+   const uint64_t journal_base = std::max<uint64_t>( _journal_base + 1, fc::time_point::now().time_since_epoch().count() );
+   {
+      std::ofstream out( ( _data_dir / "object_database.tmp" / "journal_base" ).generic_string() );
+      out << journal_base;
+      out.flush();
+      FC_ASSERT( out, "Failed to write the journal base" );
    }
    fc::remove_all( _data_dir / "object_database.tmp" / "lock" );
    if( fc::exists( _data_dir / "object_database" ) )
       fc::rename( _data_dir / "object_database", _data_dir / "object_database.old" );
    fc::rename( _data_dir / "object_database.tmp", _data_dir / "object_database" );
    fc::remove_all( _data_dir / "object_database.old" );
+   _saved_generations = std::move( saved_generations );
+   // a crash before this point leaves a journal for the old base, which open() ignores
+   _journal_base = journal_base;
+   _journal_dirty.clear();
+   if( _journal.is_open() )
+      _journal.reset( _journal_base );
+}
+
+vector< std::pair<uint8_t,uint8_t> > object_database::save_indices( const fc::path& dir )
+{
+   vector< std::pair<uint8_t,uint8_t> > ids;
+   for( uint32_t space = 0; space < _index.size(); ++space )
+      for( uint32_t type = 0; type < _index[space].size(); ++type )
+         if( _index[space][type] )
+         {
+            fc::create_directories( dir / fc::to_string(space) );
+            ids.emplace_back( space, type );
+         }
+   worker_pool( _io_threads ).run( ids.size(), [&]( size_t i ) {
+      _index[ids[i].first][ids[i].second]->save( dir / fc::to_string(ids[i].first) / fc::to_string(ids[i].second) );
+   } );
+   return ids;
+}
+
+fc::sha256 object_database::get_state_hash()const
+{
+   return get_state_hash( get_index_hashes() );
+}
+
+fc::sha256 object_database::get_state_hash( const vector<index_hash>& index_hashes )
+{
+   fc::sha256::encoder enc;
+   for( const auto& item : index_hashes )
+   {
+      fc::raw::pack( enc, item.next_id );
+      fc::raw::pack( enc, item.hash );
+   }
+   return enc.result();
+}
+
+void object_database::set_state_hash_tracking( bool track )
+{
+   _track_state_hashes = track;
+   for( auto& space : _index )
+      for( auto& idx : space )
+         if( idx )
+            idx->set_hash_tracking( track );
+}
+
+std::map< std::pair<uint32_t,uint32_t>, node_pool_stats > object_database::get_pool_stats()const
+{
+   std::map< std::pair<uint32_t,uint32_t>, node_pool_stats > result;
+   for( uint32_t space = 0; space < _index.size(); ++space )
+      for( uint32_t type = 0; type < _index[space].size(); ++type )
+         if( _index[space][type] )
+         {
+            const node_pool_stats stats = _index[space][type]->get_pool_stats();
+            if( stats.node_size != 0 )
+               result[std::make_pair( space, type )] = stats;
+         }
+   return result;
+}
+
+vector<index_hash> object_database::get_index_hashes()const
+{
+   vector<index_hash> hashes;
+   for( uint32_t space = 0; space < _index.size(); ++space )
+      for( uint32_t type = 0; type < _index[space].size(); ++type )
+         if( _index[space][type] )
+         {
+            hashes.emplace_back();
+            hashes.back().space = space;
+            hashes.back().type = type;
+            hashes.back().next_id = _index[space][type]->get_next_id();
+            hashes.back().hash = _index[space][type]->hash();
+         }
+   return hashes;
 }
 
 void object_database::wipe(const fc::path& data_dir)
 {
    close();
+   _saved_generations.clear();
+   _journal_dirty.clear();
    ilog("Wiping object database...");
    fc::remove_all(data_dir / "object_database");
+   fc::remove_all(data_dir / "object_database.journal");
    ilog("Done wiping object databse.");
 }
 
 void object_database::open(const fc::path& data_dir)
 { try {
    _data_dir = data_dir;
+   _saved_generations.clear();
+   _index_load_times.clear();
+   _journal_base = 0;
    if( fc::exists( _data_dir / "object_database" / "lock" ) )
    {
        wlog("Ignoring locked object_database");
+       open_journal();
        return;
    }
+   if( fc::exists( _data_dir / "object_database" / "journal_base" ) )
+   {
+      std::ifstream in( ( _data_dir / "object_database" / "journal_base" ).generic_string() );
+      in >> _journal_base;
+   }
    ilog("Opening object database from ${d} ...", ("d", data_dir));
+   vector< std::pair< uint32_t, uint32_t > > ids;
+   vector< fc::path > files;
    for( uint32_t space = 0; space < _index.size(); ++space )
       for( uint32_t type = 0; type  < _index[space].size(); ++type )
          if( _index[space][type] )
-            _index[space][type]->open( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
+         {
+            ids.emplace_back( space, type );
+            files.push_back( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
+         }
+
+   // unpacking dominates, inserting stays on this thread and in index order so secondary indices see the
+   // same sequence of objects as a sequential open
+   vector< std::function<void()> > inserts( ids.size() );
+   vector< fc::microseconds > read_times( ids.size() );
+   worker_pool( _io_threads ).run( ids.size(), [&]( size_t i ) {
+      const auto start = fc::time_point::now();
+      inserts[i] = _index[ids[i].first][ids[i].second]->read_saved( files[i] );
+      read_times[i] = fc::time_point::now() - start;
+   } );
+   for( size_t i = 0; i < ids.size(); ++i )
+   {
+      const auto start = fc::time_point::now();
+      inserts[i]();
+      inserts[i] = std::function<void()>(); // frees the unpacked copies
+      _index_load_times[ids[i]] = read_times[i] + ( fc::time_point::now() - start );
+      if( fc::exists( files[i] ) )
+         _saved_generations[ids[i]] = _index[ids[i].first][ids[i].second]->generation();
+   }
+   open_journal();
    ilog( "Done opening object database." );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
 
+void object_database::open_journal()
+{
+   const fc::path file = _data_dir / "object_database.journal";
+   _journal_dirty.clear();
+   _journal_suspended = false;
+   if( !_journal_enabled )
+   {
+      // a journal left from an earlier run would not match the state once this one flushes
+      _journal.close();
+      fc::remove_all( file );
+      return;
+   }
+
+   const auto positions = state_journal::scan( file, _journal_base );
+   uint64_t keep_size = 0;
+   if( !positions.empty() )
+   {
+      // popping a block needs undo history the journal does not have, so only irreversible blocks are applied
+      // and the owner applies the rest again from its block log
+      const uint32_t last_irreversible = positions.back().last_irreversible_block_num;
+      size_t count = positions.size();
+      while( count > 0 && positions[count-1].block_num > last_irreversible )
+         --count;
+      if( count > 0 )
+      {
+         keep_size = positions[count-1].end;
+         state_journal::read( file, _journal_base, keep_size, [this]( const journal_record& record ) {
+            // removals first, an object of the record may have taken over the unique keys of a removed one
+            for( const auto& id : record.removed )
+               get_mutable_index( id ).restore_removed( id );
+            // in id order, journals are written that way but the order must not depend on the writer
+            std::vector< const std::pair< object_id_type, std::vector<char> >* > objects;
+            objects.reserve( record.objects.size() );
+            for( const auto& item : record.objects )
+               objects.push_back( &item );
+            std::sort( objects.begin(), objects.end(), []( const std::pair< object_id_type, std::vector<char> >* a,
+                                                           const std::pair< object_id_type, std::vector<char> >* b ) {
+               return a->first < b->first;
+            });
+            for( const auto* item : objects )
+               get_mutable_index( item->first ).restore( item->second );
+            for( const auto& next_id : record.next_ids )
+               get_mutable_index( next_id ).set_next_id( next_id );
+         } );
+         ilog( "Applied ${n} journaled blocks up to block ${b}", ("n", count)("b", positions[count-1].block_num) );
+      }
+   }
+   _journal.open( file, _journal_base, keep_size );
+}
+
+void object_database::set_journal_suspended( bool suspended )
+{ try {
+   if( _journal_suspended && !suspended && _journal.is_open() )
+   {
+      // the journal does not hold what was applied while suspended, it starts over on a state that does
+      _journal_suspended = false;
+      flush();
+   }
+   _journal_suspended = suspended;
+} FC_CAPTURE_AND_RETHROW( (suspended) ) }
+
+void object_database::with_undo_states_rewound( size_t undo_states, const std::function<void()>& task )
+{ try {
+   auto lock = lock_views();
+   const auto before = _undo_db.state_before( undo_states );
+
+   vector< std::pair< object_id_type, vector<char> > > current_objects;
+   vector< object_id_type > current_absent;
+   vector< object_id_type > current_next_ids;
+   for( const auto& item : before.objects )
+   {
+      const object* obj = find_object( item.first );
+      if( obj != nullptr )
+         current_objects.emplace_back( item.first, obj->pack() );
+      else
+         current_absent.push_back( item.first );
+   }
+   for( const auto& item : before.next_ids )
+      current_next_ids.push_back( get_index( item.first.first, item.first.second ).get_next_id() );
+
+   // removals first in both directions, a version put in place may hold the unique keys of a removed one
+   for( const auto& item : before.objects )
+      if( item.second == nullptr )
+         get_mutable_index( item.first ).restore_removed( item.first );
+   for( const auto& item : before.objects )
+      if( item.second != nullptr )
+         get_mutable_index( item.first ).restore( item.second->pack() );
+   for( const auto& item : before.next_ids )
+      get_mutable_index( item.first.first, item.first.second ).set_next_id( item.second );
+
+   const auto put_back = [&]() {
+      for( const auto& id : current_absent )
+         get_mutable_index( id ).restore_removed( id );
+      for( const auto& item : current_objects )
+         get_mutable_index( item.first ).restore( item.second );
+      for( const auto& next_id : current_next_ids )
+         get_mutable_index( next_id ).set_next_id( next_id );
+      // a flush empties the journal, which then has to carry them on top of the state it wrote
+      if( _journal.is_open() && !_journal_suspended )
+         for( const auto& item : before.objects )
+            _journal_dirty.insert( item.first );
+   };
+   try
+   {
+      task();
+   }
+   catch( ... )
+   {
+      put_back();
+      throw;
+   }
+   put_back();
+} FC_CAPTURE_AND_RETHROW( (undo_states) ) }
+
+void object_database::journal_commit( uint32_t block_num, uint32_t last_irreversible_block_num )
+{ try {
+   if( !_journal.is_open() || _journal_suspended )
+      return;
+   journal_record record;
+   record.block_num = block_num;
+   record.last_irreversible_block_num = last_irreversible_block_num;
+   for( const auto& space : _index )
+      for( const auto& idx : space )
+         if( idx )
+            record.next_ids.push_back( idx->get_next_id() );
+   // in id order, so the record does not depend on the order of the hash set
+   std::vector< object_id_type > dirty( _journal_dirty.begin(), _journal_dirty.end() );
+   std::sort( dirty.begin(), dirty.end() );
+   for( const auto& id : dirty )
+   {
+      const object* obj = find_object( id );
+      if( obj != nullptr )
+         record.objects.emplace_back( id, obj->pack() );
+      else
+         record.removed.push_back( id );
+   }
+   _journal.append( record );
+   _journal_dirty.clear();
+} FC_CAPTURE_AND_RETHROW( (block_num)(last_irreversible_block_num) ) }
+
 
 void object_database::pop_undo()
 { try {
@@ -120,17 +419,42 @@ void object_database::pop_undo()
 
 void object_database::save_undo( const object& obj )
 {
+   if( _journal.is_open() && !_journal_suspended )
+      _journal_dirty.insert( obj.id );
+   for( auto* view : _views )
+      view->preserve( obj );
    _undo_db.on_modify( obj );
 }
 
 void object_database::save_undo_add( const object& obj )
 {
+   if( _journal.is_open() && !_journal_suspended )
+      _journal_dirty.insert( obj.id );
+   for( auto* view : _views )
+      view->preserve_absent( obj );
    _undo_db.on_create( obj );
 }
 
 void object_database::save_undo_remove(const object& obj)
 {
+   if( _journal.is_open() && !_journal_suspended )
+      _journal_dirty.insert( obj.id );
+   for( auto* view : _views )
+      view->preserve( obj );
    _undo_db.on_remove( obj );
 }
 
+std::shared_ptr<const read_view> object_database::open_read_view()
+{
+   return std::make_shared<read_view>( *this );
+}
+
+std::unique_lock<std::recursive_mutex> object_database::lock_views()
+{
+   // views only open on the thread making the changes, so none can appear while the lock is deferred
+   if( _open_views == 0 )
+      return std::unique_lock<std::recursive_mutex>( _views_mutex, std::defer_lock );
+   return std::unique_lock<std::recursive_mutex>( _views_mutex );
+}
+
 } } // namespace graphene::db
@@ -0,0 +1,105 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/db/read_view.hpp>
+#include <graphene/db/object_database.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace db {
+
+read_view::read_view( object_database& db )
+:_db(db)
+{
+   std::lock_guard<std::recursive_mutex> lock( _db._views_mutex );
+   _db._views.push_back( this );
+   ++_db._open_views;
+}
+
+read_view::~read_view()
+{
+   std::lock_guard<std::recursive_mutex> lock( _db._views_mutex );
+   _db._views.erase( std::find( _db._views.begin(), _db._views.end(), this ) );
+   --_db._open_views;
+}
+
+std::shared_ptr<const object> read_view::find_object( object_id_type id )const
+{
+   std::lock_guard<std::recursive_mutex> lock( _db._views_mutex );
+   auto itr = _preserved.find( id );
+   if( itr != _preserved.end() )
+      return itr->second;
+   const object* obj = _db.find_object( id );
+   if( obj == nullptr )
+      return std::shared_ptr<const object>();
+   return std::shared_ptr<const object>( obj->clone() );
+}
+
+std::vector< std::shared_ptr<const object> > read_view::get_objects( uint8_t space_id, uint8_t type_id )const
+{
+   std::vector< std::shared_ptr<const object> > result;
+   // objects copied from the live index, unchanged as of the view even if a later batch preserves them
+   std::unordered_set<object_id_type> read_live;
+   const index& idx = _db.get_index( space_id, type_id );
+   std::unique_lock<std::recursive_mutex> lock( _db._views_mutex );
+   for( uint64_t instance = 0; instance < idx.get_next_id().instance(); )
+   {
+      const uint64_t next_instance = idx.get_next_id().instance();
+      for( size_t n = 0; n < batch_size && instance < next_instance; ++n, ++instance )
+      {
+         const object_id_type id( space_id, type_id, instance );
+         if( _preserved.find( id ) != _preserved.end() )
+            continue;
+         const object* obj = idx.find( id );
+         if( obj != nullptr )
+         {
+            result.emplace_back( obj->clone() );
+            read_live.insert( id );
+         }
+      }
+      lock.unlock();
+      if( _batch_observer )
+         _batch_observer();
+      lock.lock();
+   }
+
+   for( const auto& item : _preserved )
+      if( item.second && item.first.space() == space_id && item.first.type() == type_id && !read_live.count( item.first ) )
+         result.push_back( item.second );
+   return result;
+}
+
+void read_view::preserve( const object& obj )
+{
+   // only the first change counts, later ones would overwrite the state as of the view
+   if( _preserved.find( obj.id ) == _preserved.end() )
+      _preserved.emplace( obj.id, std::shared_ptr<const object>( obj.clone() ) );
+}
+
+void read_view::preserve_absent( const object& obj )
+{
+   _preserved.emplace( obj.id, std::shared_ptr<const object>() );
+}
+
+} } // graphene::db
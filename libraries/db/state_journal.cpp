@@ -0,0 +1,147 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/db/state_journal.hpp>
+
+#include <fc/crypto/city.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <limits>
+
+namespace graphene { namespace db {
+
+namespace {
+   const uint64_t journal_magic = 0x4c4e524a45485047ull; // "GPHEJRNL"
+   const uint64_t journal_header_size = 2 * sizeof(uint64_t);
+   const uint64_t record_header_size = sizeof(uint32_t) + sizeof(uint64_t);
+}
+
+uint64_t state_journal::for_each_record( const fc::path& file, uint64_t base, uint64_t end,
+                                        const std::function<void(const std::vector<char>&, uint64_t)>& f )
+{
+   if( !fc::exists( file ) )
+      return 0;
+   const uint64_t file_size = std::min( fc::file_size( file ), end );
+   std::ifstream in( file.generic_string(), std::ifstream::binary );
+   uint64_t magic = 0;
+   uint64_t file_base = 0;
+   in.read( (char*)&magic, sizeof(magic) );
+   in.read( (char*)&file_base, sizeof(file_base) );
+   if( !in || magic != journal_magic || file_base != base )
+      return 0;
+
+   uint64_t pos = journal_header_size;
+   std::vector<char> data;
+   while( pos + record_header_size <= file_size )
+   {
+      uint32_t size = 0;
+      uint64_t checksum = 0;
+      in.read( (char*)&size, sizeof(size) );
+      in.read( (char*)&checksum, sizeof(checksum) );
+      if( !in || pos + record_header_size + size > file_size )
+         break;
+      data.resize( size );
+      in.read( data.data(), size );
+      if( !in || fc::city_hash64( data.data(), data.size() ) != checksum )
+         break;
+      pos += record_header_size + size;
+      f( data, pos );
+   }
+   return pos;
+}
+
+std::vector< journal_position > state_journal::scan( const fc::path& file, uint64_t base )
+{ try {
+   std::vector< journal_position > positions;
+   const uint64_t end = for_each_record( file, base, std::numeric_limits<uint64_t>::max(),
+                                         [&positions]( const std::vector<char>& data, uint64_t end ) {
+      // the block numbers lead the packed record, the objects after them are left for read()
+      fc::datastream<const char*> ds( data.data(), data.size() );
+      journal_position position;
+      fc::raw::unpack( ds, position.block_num );
+      fc::raw::unpack( ds, position.last_irreversible_block_num );
+      position.end = end;
+      positions.push_back( position );
+   } );
+   if( end > 0 && end < fc::file_size( file ) )
+      wlog( "Ignoring ${n} bytes at the end of ${f} that were not written completely",
+            ("n", fc::file_size( file ) - end)("f", file) );
+   return positions;
+} FC_CAPTURE_AND_RETHROW( (file)(base) ) }
+
+void state_journal::read( const fc::path& file, uint64_t base, uint64_t end,
+                          const std::function<void(const journal_record&)>& apply )
+{ try {
+   for_each_record( file, base, end, [&apply]( const std::vector<char>& data, uint64_t ) {
+      apply( fc::raw::unpack<journal_record>( data ) );
+   } );
+} FC_CAPTURE_AND_RETHROW( (file)(base)(end) ) }
+
+void state_journal::open( const fc::path& file, uint64_t base, uint64_t keep_size )
+{ try {
+   close();
+   _file = file;
+   if( keep_size < journal_header_size )
+   {
+      reset( base );
+      return;
+   }
+   fc::resize_file( _file, keep_size );
+   _out.open( _file.generic_string(), std::ofstream::binary | std::ofstream::out | std::ofstream::app );
+   FC_ASSERT( _out, "Unable to open ${f}", ("f", _file) );
+} FC_CAPTURE_AND_RETHROW( (file)(base)(keep_size) ) }
+
+void state_journal::close()
+{
+   if( _out.is_open() )
+      _out.close();
+}
+
+void state_journal::append( const journal_record& record )
+{
+   FC_ASSERT( is_open() );
+   const auto data = fc::raw::pack( record );
+   const uint32_t size = data.size();
+   const uint64_t checksum = fc::city_hash64( data.data(), data.size() );
+   _out.write( (const char*)&size, sizeof(size) );
+   _out.write( (const char*)&checksum, sizeof(checksum) );
+   _out.write( data.data(), data.size() );
+   _out.flush();
+   FC_ASSERT( _out, "Failed to write ${f}", ("f", _file) );
+}
+
+void state_journal::reset( uint64_t base )
+{
+   close();
+   _out.open( _file.generic_string(), std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+   FC_ASSERT( _out, "Unable to open ${f}", ("f", _file) );
+   _out.write( (const char*)&journal_magic, sizeof(journal_magic) );
+   _out.write( (const char*)&base, sizeof(base) );
+   _out.flush();
+   FC_ASSERT( _out, "Failed to write ${f}", ("f", _file) );
+}
+
+} } // graphene::db
@@ -0,0 +1,126 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/db/undo_arena.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace graphene { namespace db {
+
+std::unique_ptr<char[]> slab_pool::acquire()
+{
+   if( _free.empty() )
+      return std::unique_ptr<char[]>( new char[slab_size] );
+   auto slab = std::move( _free.back() );
+   _free.pop_back();
+   return slab;
+}
+
+void slab_pool::release( std::unique_ptr<char[]>&& slab )
+{
+   if( _free.size() < max_free_slabs )
+      _free.push_back( std::move( slab ) );
+}
+
+undo_arena::undo_arena( undo_arena&& other )
+:_pool(other._pool),_slabs(std::move(other._slabs)),_used(other._used),_large(std::move(other._large)),
+ _objects(std::move(other._objects))
+{
+   other._slabs.clear();
+   other._used = 0;
+   other._large.clear();
+   other._objects.clear();
+}
+
+undo_arena& undo_arena::operator = ( undo_arena&& other )
+{
+   if( this == &other )
+      return *this;
+   clear();
+   _pool = other._pool;
+   std::swap( _slabs, other._slabs );
+   std::swap( _used, other._used );
+   std::swap( _large, other._large );
+   std::swap( _objects, other._objects );
+   return *this;
+}
+
+object* undo_arena::clone( const object& obj )
+{
+   const size_t align = alignof(std::max_align_t);
+   const size_t size = ( obj.clone_size() + align - 1 ) & ~( align - 1 );
+   char* storage;
+   if( size > slab_pool::slab_size )
+   {
+      _large.emplace_back( new char[size] );
+      storage = _large.back().get();
+   }
+   else
+   {
+      if( _slabs.empty() || _used + size > slab_pool::slab_size )
+      {
+         _slabs.push_back( _pool != nullptr ? _pool->acquire() : std::unique_ptr<char[]>( new char[slab_pool::slab_size] ) );
+         _used = 0;
+      }
+      storage = _slabs.back().get() + _used;
+      _used += size;
+   }
+   _objects.reserve( _objects.size() + 1 );
+   object* copy = obj.clone_into( storage );
+   _objects.push_back( copy );
+   return copy;
+}
+
+void undo_arena::absorb( undo_arena& other )
+{
+   // other's slabs go in front so the one this arena is filling stays last
+   if( _slabs.empty() )
+      _used = other._used;
+   _slabs.insert( _slabs.begin(), std::make_move_iterator( other._slabs.begin() ),
+                  std::make_move_iterator( other._slabs.end() ) );
+   for( auto& block : other._large )
+      _large.push_back( std::move( block ) );
+   _objects.insert( _objects.end(), other._objects.begin(), other._objects.end() );
+   other._slabs.clear();
+   other._used = 0;
+   other._large.clear();
+   other._objects.clear();
+}
+
+void undo_arena::clear()
+{
+   for( object* obj : _objects )
+      obj->~object();
+   _objects.clear();
+   for( auto& slab : _slabs )
+      if( _pool != nullptr )
+         _pool->release( std::move( slab ) );
+   _slabs.clear();
+   _used = 0;
+   _large.clear();
+}
+
+} } // graphene::db
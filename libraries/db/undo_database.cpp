@@ -40,7 +40,7 @@ undo_database::session undo_database::start_undo_session( bool force_enable )
    while( size() > max_size() )
       _stack.pop_front();
 
-   _stack.emplace_back();
+   _stack.emplace_back( &_slabs );
    ++_active_sessions;
    return session(*this, disable_on_exit );
 }
@@ -49,7 +49,7 @@ void undo_database::on_create( const object& obj )
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      _stack.emplace_back( &_slabs );
    auto& state = _stack.back();
    auto index_id = object_id_type( obj.id.space(), obj.id.type(), 0 );
    auto itr = state.old_index_next_ids.find( index_id );
@@ -62,34 +62,32 @@ void undo_database::on_modify( const object& obj )
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      _stack.emplace_back( &_slabs );
    auto& state = _stack.back();
    if( state.new_ids.find(obj.id) != state.new_ids.end() )
       return;
    auto itr =  state.old_values.find(obj.id);
    if( itr != state.old_values.end() ) return;
-   state.old_values[obj.id] = obj.clone();
+   state.old_values[obj.id] = state.arena.clone( obj );
 }
 void undo_database::on_remove( const object& obj )
 {
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      _stack.emplace_back( &_slabs );
    undo_state& state = _stack.back();
-   if( state.new_ids.count(obj.id) )
-   {
-      state.new_ids.erase(obj.id);
+   if( state.new_ids.erase(obj.id) )
       return;
-   }
-   if( state.old_values.count(obj.id) )
+   auto itr = state.old_values.find(obj.id);
+   if( itr != state.old_values.end() )
    {
-      state.removed[obj.id] = std::move(state.old_values[obj.id]);
+      state.removed[obj.id] = itr->second;
       state.old_values.erase(obj.id);
       return;
    }
    if( state.removed.count(obj.id) ) return;
-   state.removed[obj.id] = obj.clone();
+   state.removed[obj.id] = state.arena.clone( obj );
 }
 
 void undo_database::undo()
@@ -178,7 +176,7 @@ void undo_database::merge()
    // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's three containers.
 
    // *+upd
-   for( auto& obj : state.old_values )
+   for( const auto& obj : state.old_values )
    {
       if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
       {
@@ -193,7 +191,7 @@ void undo_database::merge()
       // del+upd -> N/A
       assert( prev_state.removed.find(obj.second->id) == prev_state.removed.end() );
       // nop+upd(was=Y) -> upd(was=Y), type B
-      prev_state.old_values[obj.second->id] = std::move(obj.second);
+      prev_state.old_values[obj.second->id] = obj.second;
    }
 
    // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
@@ -201,7 +199,7 @@ void undo_database::merge()
       prev_state.new_ids.insert(id);
 
    // old_index_next_ids can only be updated, iterate over *+upd cases
-   for( auto& item : state.old_index_next_ids )
+   for( const auto& item : state.old_index_next_ids )
    {
       if( prev_state.old_index_next_ids.find( item.first ) == prev_state.old_index_next_ids.end() )
       {
@@ -218,7 +216,7 @@ void undo_database::merge()
    }
 
    // *+del
-   for( auto& obj : state.removed )
+   for( const auto& obj : state.removed )
    {
       if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
       {
@@ -230,15 +228,17 @@ void undo_database::merge()
       if( it != prev_state.old_values.end() )
       {
          // upd(was=X) + del(was=Y) -> del(was=X)
-         prev_state.removed[obj.second->id] = std::move(it->second);
+         prev_state.removed[obj.second->id] = it->second;
          prev_state.old_values.erase(obj.second->id);
          continue;
       }
       // del + del -> N/A
       assert( prev_state.removed.find( obj.second->id ) == prev_state.removed.end() );
       // nop + del(was=Y) -> del(was=Y)
-      prev_state.removed[obj.second->id] = std::move(obj.second);
+      prev_state.removed[obj.second->id] = obj.second;
    }
+   // the copies moved into prev_state above still live in state's arena
+   prev_state.arena.absorb( state.arena );
    _stack.pop_back();
    --_active_sessions;
 }
@@ -291,4 +291,23 @@ const undo_state& undo_database::head()const
    return _stack.back();
 }
 
+undo_database::prior_state undo_database::state_before( size_t count )const
+{ try {
+   FC_ASSERT( count <= _stack.size(), "Only ${s} undo states to look past", ("s", _stack.size()) );
+   prior_state result;
+   // from the top down, so that the oldest version of an object is the one kept
+   for( auto itr = _stack.rbegin(); itr != _stack.rbegin() + count; ++itr )
+   {
+      for( const auto& item : itr->old_values )
+         result.objects[item.first] = item.second;
+      for( const auto& item : itr->removed )
+         result.objects[item.first] = item.second;
+      for( const auto& id : itr->new_ids )
+         result.objects[id] = nullptr;
+      for( const auto& item : itr->old_index_next_ids )
+         result.next_ids[std::make_pair( item.first.space(), item.first.type() )] = item.second;
+   }
+   return result;
+} FC_CAPTURE_AND_RETHROW( (count) ) }
+
 } } // graphene::db
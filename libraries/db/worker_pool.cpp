@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/db/worker_pool.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <exception>
+#include <thread>
+
+namespace graphene { namespace db {
+
+worker_pool::worker_pool( uint32_t num_threads )
+{
+   if( num_threads == 0 )
+      num_threads = std::max( std::thread::hardware_concurrency(), 1u );
+   _threads.reserve( num_threads );
+   for( uint32_t i = 0; i < num_threads; ++i )
+      _threads.emplace_back( new fc::thread( "worker_pool_" + std::to_string( i ) ) );
+}
+
+worker_pool::~worker_pool()
+{
+   for( auto& thread : _threads )
+      thread->quit();
+}
+
+void worker_pool::run( size_t count, const std::function<void(size_t)>& task )
+{
+   if( count == 0 )
+      return;
+
+   std::atomic<size_t> next_task( 0 );
+   const size_t num_workers = std::min( count, _threads.size() );
+   std::vector< fc::future<void> > workers;
+   workers.reserve( num_workers );
+   for( size_t i = 0; i < num_workers; ++i )
+      workers.push_back( _threads[i]->async( [&]() {
+         for( size_t t = next_task++; t < count; t = next_task++ )
+            task( t );
+      }, "worker_pool_run" ) );
+
+   std::exception_ptr first_error;
+   for( auto& worker : workers )
+   {
+      try
+      {
+         worker.wait();
+      }
+      catch( ... )
+      {
+         if( !first_error )
+            first_error = std::current_exception();
+      }
+   }
+   if( first_error )
+      std::rethrow_exception( first_error );
+}
+
+} } // graphene::db
@@ -46,5 +46,28 @@ namespace graphene { namespace net {
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
 
+  message block_message::from_packed_block( std::vector<char>&& packed_block, const block_id_type& id )
+  {
+    // block_message is reflected as (block)(block_id), so its packed form is the packed block followed by the id
+    const std::vector<char> packed_id = fc::raw::pack( id );
+    message result;
+    result.msg_type = block_message::type;
+    result.data = std::move( packed_block );
+    result.data.insert( result.data.end(), packed_id.begin(), packed_id.end() );
+    result.size = (uint32_t)result.data.size();
+    return result;
+  }
+
+  block_id_type block_message::block_id_from_message( const message& msg )
+  {
+    FC_ASSERT( msg.msg_type == block_message::type );
+    const size_t id_size = fc::raw::pack_size( block_id_type() );
+    FC_ASSERT( msg.data.size() >= id_size );
+    block_id_type result;
+    fc::datastream<const char*> ds( msg.data.data() + msg.data.size() - id_size, id_size );
+    fc::raw::unpack( ds, result );
+    return result;
+  }
+
 } } // graphene::net
 
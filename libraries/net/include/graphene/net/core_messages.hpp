@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/net/config.hpp>
+#include <graphene/net/message.hpp>
 #include <graphene/chain/protocol/block.hpp>
 
 #include <fc/crypto/ripemd160.hpp>
@@ -113,6 +114,15 @@ namespace graphene { namespace net {
       signed_block    block;
       block_id_type   block_id;
 
+      /**
+       * Builds the wire form of a block_message around a block that is already packed, e.g. as returned by
+       * block_database::fetch_raw(). The result is byte-for-byte the same as message(block_message(blk)), but
+       * the block is never unpacked or packed again.
+       */
+      static message from_packed_block( std::vector<char>&& packed_block, const block_id_type& id );
+
+      /** Reads block_id from a packed block_message without unpacking the block in front of it */
+      static block_id_type block_id_from_message( const message& msg );
    };
 
   struct item_ids_inventory_message
@@ -2299,15 +2299,15 @@ namespace graphene { namespace net { namespace detail {
       // if we sent them a block, update our record of the last block they've seen accordingly
       if (last_block_message_sent)
       {
-        graphene::net::block_message block = last_block_message_sent->as<graphene::net::block_message>();
-        originating_peer->last_block_delegate_has_seen = block.block_id;
-        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
+        block_id_type last_block_id_sent = graphene::net::block_message::block_id_from_message(*last_block_message_sent);
+        originating_peer->last_block_delegate_has_seen = last_block_id_sent;
+        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(last_block_id_sent);
       }
 
       for (const message& reply : reply_messages)
       {
         if (reply.msg_type == block_message_type)
-          originating_peer->send_item(item_id(block_message_type, reply.as<graphene::net::block_message>().block_id));
+          originating_peer->send_item(item_id(block_message_type, graphene::net::block_message::block_id_from_message(reply)));
         else
           originating_peer->send_message(reply);
       }
@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/block_database.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/thread/thread.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <algorithm>
+#include <random>
+
+using namespace graphene::chain;
+
+namespace {
+
+/**
+ * Fetches `fetches` random blocks in [1, block_count] on `threads` threads and returns the
+ * number of blocks fetched per second.
+ */
+double random_fetch_rate( const block_database& bdb, uint32_t block_count, uint32_t fetches, uint32_t threads )
+{
+   std::vector<std::unique_ptr<fc::thread>> workers;
+   std::vector<fc::future<void>> done;
+   const auto start = fc::time_point::now();
+   for( uint32_t t = 0; t < threads; ++t )
+   {
+      workers.emplace_back( new fc::thread( "block_database_bench_" + fc::to_string(t) ) );
+      done.push_back( workers.back()->async( [&bdb, block_count, fetches, threads, t]() {
+         std::mt19937 rng( t );
+         std::uniform_int_distribution<uint32_t> dist( 1, block_count );
+         for( uint32_t i = 0; i < fetches / threads; ++i )
+            FC_ASSERT( bdb.fetch_by_number( dist( rng ) ).valid() );
+      }, "random_fetch" ) );
+   }
+   for( auto& f : done )
+      f.wait();
+   const auto elapsed = fc::time_point::now() - start;
+   for( auto& w : workers )
+      w->quit();
+   return double( fetches ) * 1000000 / std::max<int64_t>( elapsed.count(), 1 );
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( block_database_random_fetch_bench )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t block_count = 200000;
+      const uint32_t fetches = 1000000;
+#else
+      const uint32_t block_count = 20000;
+      const uint32_t fetches = 100000;
+#endif
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      {
+         block_database bdb;
+         bdb.open( data_dir.path() );
+         signed_block b;
+         b.transaction_merkle_root = fc::ripemd160::hash( "block_database_random_fetch_bench" );
+         for( uint32_t i = 0; i < block_count; ++i )
+         {
+            if( i > 0 ) b.previous = b.id();
+            b.timestamp = fc::time_point_sec( i * 3 );
+            bdb.store( b.id(), b );
+         }
+         bdb.close();
+      }
+
+      {
+         block_database bdb;
+         bdb.open( data_dir.path() );
+         // the fstream path shares one stream position, so it can only be used by one thread
+         ilog( "fstream, 1 thread: ${r} blocks/s", ("r", random_fetch_rate( bdb, block_count, fetches, 1 )) );
+         bdb.close();
+      }
+
+      block_database_options options;
+      options.memory_mapped = true;
+      block_database bdb;
+      bdb.open( data_dir.path(), options );
+      for( uint32_t threads : { 1, 2, 4, 8 } )
+         ilog( "mmap, ${t} thread(s): ${r} blocks/s",
+               ("t", threads)("r", random_fetch_rate( bdb, block_count, fetches, threads )) );
+      bdb.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
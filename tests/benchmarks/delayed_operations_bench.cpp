@@ -0,0 +1,128 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/daspay_object.hpp>
+#include <graphene/chain/global_property_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+#include <algorithm>
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+namespace {
+
+/** Every due_every'th operation is due now, the rest is due a day after the head block */
+void create_delayed_operations( database& db, uint32_t& next_account, uint32_t count, uint32_t due_every )
+{
+   const asset nothing( 0, db.get_dascoin_asset_id() );
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      const account_id_type account( next_account++ );
+      db.create<delayed_operation_object>( [&]( delayed_operation_object& dlo ) {
+         dlo.account = account;
+         dlo.op = unreserve_asset_on_account_operation( account, nothing );
+         dlo.issued_time = db.head_block_time();
+         dlo.skip = i % due_every == 0 ? 0 : 86400;
+      } );
+   }
+}
+
+/** Generates blocks until no delayed operation is due and returns the longest delayed_operations phase in us */
+uint64_t longest_resolver_phase( database_fixture& f, uint32_t& blocks )
+{
+   database& db = f.db;
+   db.modify( db.get_dynamic_global_properties(), [&]( dynamic_global_property_object& dgpo ) {
+      dgpo.next_delayed_operations_resolver_time = db.head_block_time();
+   } );
+   uint64_t longest = 0;
+   blocks = 0;
+   do
+   {
+      f.generate_block();
+      ++blocks;
+      longest = std::max( longest, db.get_block_profiler().get_last_block().phases["delayed_operations"] );
+   } while( db.get_dynamic_global_properties().next_delayed_operations_resolver_time <= db.head_block_time() );
+   return longest;
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE( delayed_operations_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t pending_count = 500000;
+#else
+      const uint32_t pending_count = 20000;
+#endif
+      // one in a hundred pending operations is due, the shape of a resolver interval under DasPay load
+      uint32_t next_account = 1000000;
+      create_delayed_operations( db, next_account, pending_count, 100 );
+      db.modify( db.get_global_properties(), []( global_property_object& gpo ) {
+         gpo.delayed_operations_resolver_enabled = true;
+      } );
+      db.get_block_profiler().set_enabled( true );
+
+      // the scan over every pending operation that the due time index replaced
+      const auto& by_account_idx = db.get_index_type<delayed_operations_index>().indices().get<by_account>();
+      auto start = fc::time_point::now();
+      uint32_t due = 0;
+      for( const auto& dlo : by_account_idx )
+         if( dlo.issued_time + dlo.skip <= db.head_block_time() )
+            ++due;
+      ilog( "by_account scan over ${p} pending operations, ${d} due: ${t} us",
+            ("p", pending_count)("d", due)("t", (fc::time_point::now() - start).count()) );
+
+      uint32_t blocks = 0;
+      uint64_t longest = longest_resolver_phase( *this, blocks );
+      ilog( "by_due_time, one block: ${t} us, ${p} operations left pending",
+            ("t", longest)("p", by_account_idx.size()) );
+
+      // a backlog where everything is due at once, spread over blocks
+      for( uint32_t operations_per_block : { 10000, 1000 } )
+      {
+         create_delayed_operations( db, next_account, pending_count, 1 );
+         db.modify( db.get_global_properties(), [&]( global_property_object& gpo ) {
+            delayed_operations_resolver_batch_type batch;
+            batch.operations_per_block = operations_per_block;
+            gpo.parameters.extensions.erase( chain_parameters::chain_parameters_extension( batch ) );
+            gpo.parameters.extensions.insert( batch );
+         } );
+         const auto pending_before = by_account_idx.size();
+         longest = longest_resolver_phase( *this, blocks );
+         ilog( "by_due_time, ${n} operations per block: longest block ${t} us over ${b} blocks, ${r} resolved",
+               ("n", operations_per_block)("t", longest)("b", blocks)("r", pending_before - by_account_idx.size()) );
+      }
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
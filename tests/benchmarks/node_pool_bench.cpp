@@ -0,0 +1,139 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/market_object.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <unistd.h>
+
+using namespace graphene::chain;
+
+namespace {
+   /** calls to the global operator new, whoever makes them */
+   std::atomic<uint64_t> allocator_calls( 0 );
+}
+
+void* operator new( std::size_t size )
+{
+   ++allocator_calls;
+   if( void* p = std::malloc( size ? size : 1 ) )
+      return p;
+   throw std::bad_alloc();
+}
+
+void operator delete( void* p ) noexcept
+{
+   std::free( p );
+}
+
+namespace {
+
+/** resident set size in bytes, from /proc/self/statm */
+uint64_t resident_bytes()
+{
+   std::ifstream statm( "/proc/self/statm" );
+   uint64_t size = 0;
+   uint64_t resident = 0;
+   statm >> size >> resident;
+   return resident * sysconf( _SC_PAGESIZE );
+}
+
+/** fills a container and then keeps replacing half of its orders, like a busy order book */
+template<typename Container>
+void churn( Container& orders, const string& label )
+{
+#ifdef NDEBUG
+   const uint64_t order_count = 500000;
+   const uint32_t rounds = 40;
+#else
+   const uint64_t order_count = 50000;
+   const uint32_t rounds = 10;
+#endif
+   const uint64_t rss_before = resident_bytes();
+   const uint64_t calls_before = allocator_calls;
+   const auto start = fc::time_point::now();
+   uint64_t next_id = 0;
+   for( ; next_id < order_count; ++next_id )
+   {
+      limit_order_object o;
+      o.id = limit_order_id_type( next_id );
+      o.expiration = fc::time_point_sec( next_id % 86400 );
+      orders.insert( std::move( o ) );
+   }
+   for( uint32_t round = 0; round < rounds; ++round )
+   {
+      auto& by_ids = orders.template get<by_id>();
+      for( auto itr = by_ids.begin(); itr != by_ids.end(); )
+      {
+         itr = by_ids.erase( itr );
+         if( itr != by_ids.end() )
+            ++itr;
+      }
+      while( orders.size() < order_count )
+      {
+         limit_order_object o;
+         o.id = limit_order_id_type( next_id );
+         o.expiration = fc::time_point_sec( next_id % 86400 );
+         orders.insert( std::move( o ) );
+         ++next_id;
+      }
+   }
+   ilog( "${l}: ${n} inserts in ${ms} milliseconds, ${c} allocator calls, resident set grew by ${mb} MiB",
+         ("l", label)("n", next_id)("ms", (fc::time_point::now() - start).count() / 1000)
+         ("c", allocator_calls - calls_before)
+         ("mb", ( int64_t( resident_bytes() ) - int64_t( rss_before ) ) / ( 1024 * 1024 )) );
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( node_pool_bench )
+{
+   try {
+      typedef multi_index_with_allocator< limit_order_multi_index_type,
+                                          node_pool_allocator<limit_order_object> >::type pooled_type;
+      {
+         limit_order_multi_index_type orders;
+         churn( orders, "std::allocator" );
+      }
+      {
+         node_pool pool;
+         pooled_type orders( pooled_type::ctor_args_list(), node_pool_allocator<limit_order_object>( &pool ) );
+         churn( orders, "node_pool_allocator" );
+         const auto& stats = pool.stats();
+         ilog( "pool: ${n} nodes of ${s} bytes in use, ${f} free, ${b} MiB in ${a} slabs for ${c} node allocations",
+               ("n", stats.nodes_in_use)("s", stats.node_size)("f", stats.free_nodes)
+               ("b", stats.slab_bytes / ( 1024 * 1024 ))("a", stats.slab_allocations)("c", stats.node_allocations) );
+      }
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
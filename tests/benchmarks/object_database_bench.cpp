@@ -0,0 +1,90 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/crypto/digest.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <algorithm>
+
+using namespace graphene::chain;
+
+BOOST_AUTO_TEST_CASE( object_database_startup_bench )
+{
+   try {
+#ifdef NDEBUG
+      const int account_count = 1000000;
+#else
+      const int account_count = 30000;
+#endif
+      genesis_state_type genesis_state;
+      for( int i = 0; i < account_count; ++i )
+         genesis_state.initial_accounts.emplace_back("target"+fc::to_string(i),
+                                                     public_key_type(fc::ecc::private_key::regenerate(fc::digest(i)).get_public_key()));
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      {
+         database db;
+         db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+         db.close();
+      }
+
+      for( uint32_t threads : { 1, 2, 4, 8 } )
+      {
+         database db;
+         db.set_io_threads( threads );
+         const auto start_time = fc::time_point::now();
+         db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+         ilog( "Opened database with ${t} thread(s) in ${ms} milliseconds.",
+               ("t", threads)("ms", (fc::time_point::now() - start_time).count() / 1000) );
+
+         // the slowest indices bound how far more threads can help
+         vector< std::pair< fc::microseconds, std::pair<uint32_t,uint32_t> > > load_times;
+         for( const auto& item : db.get_index_load_times() )
+            load_times.emplace_back( item.second, item.first );
+         std::sort( load_times.rbegin(), load_times.rend() );
+         for( size_t i = 0; i < std::min<size_t>( load_times.size(), 5 ); ++i )
+            ilog( "   index ${s}.${t}: ${ms} milliseconds",
+                  ("s", load_times[i].second.first)("t", load_times[i].second.second)
+                  ("ms", load_times[i].first.count() / 1000) );
+
+         BOOST_CHECK( db.get_index_type<account_index>().indices().size() >= size_t(account_count) );
+
+         // nothing changed since the open, so this only measures linking the files back
+         const auto flush_start = fc::time_point::now();
+         db.flush();
+         ilog( "Flushed unchanged database in ${ms} milliseconds.",
+               ("ms", (fc::time_point::now() - flush_start).count() / 1000) );
+         db.close();
+      }
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
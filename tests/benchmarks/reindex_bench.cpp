@@ -0,0 +1,131 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/signature_cache.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/crypto/digest.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <algorithm>
+
+using namespace graphene::chain;
+
+namespace {
+
+genesis_state_type make_reindex_genesis()
+{
+   genesis_state_type genesis_state;
+   genesis_state.initial_timestamp = fc::time_point_sec( GRAPHENE_TESTING_GENESIS_TIMESTAMP );
+
+   auto init_account_priv_key = fc::ecc::private_key::regenerate( fc::sha256::hash( std::string( "null_key" ) ) );
+   genesis_state.initial_active_witnesses = 10;
+   for( unsigned int i = 0; i < genesis_state.initial_active_witnesses; ++i )
+   {
+      auto name = "init" + fc::to_string( i );
+      genesis_state.initial_accounts.emplace_back( name,
+                                                   init_account_priv_key.get_public_key(),
+                                                   init_account_priv_key.get_public_key(),
+                                                   true );
+      genesis_state.initial_committee_candidates.push_back( {name} );
+      genesis_state.initial_witness_candidates.push_back( {name, init_account_priv_key.get_public_key()} );
+   }
+   genesis_state.initial_parameters.current_fees->zero_all_fees();
+   return genesis_state;
+}
+
+/**
+ * Replays the block log in data_dir onto an empty object database and returns the blocks applied per second.
+ * run must differ between calls, it makes open() find an object database of another version and replay.
+ */
+double replay_rate( const fc::path& data_dir, const genesis_state_type& genesis_state, uint32_t run,
+                    uint32_t prefetch_blocks, bool verify_signatures )
+{
+   // keys recovered by an earlier run would make verifying look cheaper than it is
+   signature_cache::instance().clear();
+   database db;
+   db.set_reindex_prefetch_blocks( prefetch_blocks );
+   db.set_replay_verify_signatures( verify_signatures );
+   const auto start = fc::time_point::now();
+   db.open( data_dir, [&]{ return genesis_state; }, "reindex_bench_" + fc::to_string( run ) );
+   const auto elapsed = fc::time_point::now() - start;
+   const uint32_t blocks = db.head_block_num();
+   db.close();
+   return double( blocks ) * 1000000 / std::max<int64_t>( elapsed.count(), 1 );
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( reindex_prefetch_bench )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t block_count = 100000;
+#else
+      const uint32_t block_count = 5000;
+#endif
+      const uint32_t transactions_per_block = 10;
+      const genesis_state_type genesis_state = make_reindex_genesis();
+      auto init_account_priv_key = fc::ecc::private_key::regenerate( fc::sha256::hash( std::string( "null_key" ) ) );
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      {
+         database db;
+         db.open( data_dir.path(), [&]{ return genesis_state; }, "reindex_bench" );
+         const account_id_type payer = db.get_index_type<account_index>().indices().get<by_name>().find( "init0" )->id;
+         for( uint32_t i = 0; i < block_count; ++i )
+         {
+            for( uint32_t t = 0; t < transactions_per_block; ++t )
+            {
+               // a no-op that replays with zero fees, so the blocks only cost reading, signatures and applying
+               assert_operation op;
+               op.fee_paying_account = payer;
+               signed_transaction trx;
+               trx.operations.push_back( op );
+               trx.set_expiration( db.head_block_time() + fc::seconds( 60 + t ) );
+               trx.set_reference_block( db.head_block_id() );
+               trx.sign( init_account_priv_key, db.get_chain_id() );
+               db.push_transaction( trx );
+            }
+            db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), init_account_priv_key,
+                               database::skip_nothing );
+         }
+         db.close();
+      }
+
+      uint32_t run = 0;
+      for( bool verify_signatures : { false, true } )
+         for( uint32_t prefetch_blocks : { 0, 100, 1000 } )
+            ilog( "replay, ${p} blocks prefetched, signatures ${v}: ${r} blocks/s",
+                  ("p", prefetch_blocks)("v", verify_signatures ? "verified" : "skipped")
+                  ("r", replay_rate( data_dir.path(), genesis_state, ++run, prefetch_blocks, verify_signatures )) );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,130 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/global_property_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+#include <algorithm>
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+namespace {
+
+void create_accounts( database& db, uint32_t count, account_kind kind, asset_id_type limited_asset )
+{
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      const account_object& account = db.create<account_object>( [&]( account_object& a ) {
+         a.kind = kind;
+         a.name = "bench-" + fc::to_string( uint64_t( a.id.instance() ) );
+         a.statistics = db.create<account_statistics_object>( [&a]( account_statistics_object& s ) {
+            s.owner = a.id;
+            s.name = a.name;
+         } ).id;
+         a.owner.weight_threshold = 1;
+         a.active.weight_threshold = 1;
+         a.registrar = a.lifetime_referrer = a.referrer = GRAPHENE_COMMITTEE_ACCOUNT;
+      } );
+      db.create<account_balance_object>( [&]( account_balance_object& b ) {
+         b.owner = account.get_id();
+         b.asset_type = limited_asset;
+      } );
+   }
+}
+
+/** Generates blocks until a spending limit reset is done and returns the longest reset_spending_limits phase in us */
+uint64_t longest_reset_phase( database_fixture& f, uint32_t& blocks )
+{
+   database& db = f.db;
+   db.modify( db.get_dynamic_global_properties(), [&]( dynamic_global_property_object& dgpo ) {
+      dgpo.next_spend_limit_reset = db.head_block_time();
+   } );
+   uint64_t longest = 0;
+   blocks = 0;
+   do
+   {
+      f.generate_block();
+      ++blocks;
+      longest = std::max( longest, db.get_block_profiler().get_last_block().phases["reset_spending_limits"] );
+   } while( db.get_dynamic_global_properties().next_spend_limit_reset_account.valid() );
+   return longest;
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE( spending_limit_reset_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t wallet_count = 500000;
+      const uint32_t vault_count = 50000;
+#else
+      const uint32_t wallet_count = 20000;
+      const uint32_t vault_count = 2000;
+#endif
+      create_accounts( db, wallet_count, account_kind::wallet, get_dascoin_asset_id() );
+      create_accounts( db, vault_count, account_kind::vault, get_dascoin_asset_id() );
+      db.get_block_profiler().set_enabled( true );
+
+      // the sweep over every account that the vault index replaced
+      const auto& dgpo = db.get_dynamic_global_properties();
+      auto start = fc::time_point::now();
+      for( const auto& account : db.get_index_type<account_index>().indices().get<by_id>() )
+      {
+         auto dsc_limit = db.get_dascoin_limit( account, dgpo.last_dascoin_price );
+         if( dsc_limit.valid() )
+            db.adjust_balance_limit( account, get_dascoin_asset_id(), *dsc_limit, true );
+      }
+      ilog( "all-accounts sweep over ${w} wallets and ${v} vaults: ${t} us",
+            ("w", wallet_count)("v", vault_count)("t", (fc::time_point::now() - start).count()) );
+
+      uint32_t blocks = 0;
+      uint64_t longest = longest_reset_phase( *this, blocks );
+      ilog( "vault index, one block: ${t} us", ("t", longest) );
+
+      for( uint32_t accounts_per_block : { 10000, 1000 } )
+      {
+         db.modify( db.get_global_properties(), [&]( global_property_object& gpo ) {
+            spending_limit_reset_batch_type batch;
+            batch.accounts_per_block = accounts_per_block;
+            gpo.parameters.extensions.erase( chain_parameters::chain_parameters_extension( batch ) );
+            gpo.parameters.extensions.insert( batch );
+         } );
+         longest = longest_reset_phase( *this, blocks );
+         ilog( "vault index, ${n} vaults per block: longest block ${t} us over ${b} blocks",
+               ("n", accounts_per_block)("t", longest)("b", blocks) );
+      }
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,93 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/crypto/digest.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+BOOST_AUTO_TEST_CASE( undo_database_modify_bench )
+{
+   try {
+#ifdef NDEBUG
+      const int account_count = 200000;
+      const int session_count = 2000;
+#else
+      const int account_count = 20000;
+      const int session_count = 200;
+#endif
+      const int modifies_per_session = 5000;
+      genesis_state_type genesis_state;
+      for( int i = 0; i < account_count; ++i )
+         genesis_state.initial_accounts.emplace_back("target"+fc::to_string(i),
+                                                     public_key_type(fc::ecc::private_key::regenerate(fc::digest(i)).get_public_key()));
+
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      database db;
+      db.open(data_dir.path(), [&]{return genesis_state;}, "test");
+
+      vector<account_id_type> ids;
+      for( const auto& a : db.get_index_type<account_index>().indices() )
+         ids.push_back( a.id );
+
+      // like blocks: most sessions are committed and later dropped from the bottom of the stack, some are undone
+      const auto start_time = fc::time_point::now();
+      uint64_t modified = 0;
+      for( int s = 0; s < session_count; ++s )
+      {
+         auto session = db._undo_db.start_undo_session();
+         for( int m = 0; m < modifies_per_session; ++m )
+         {
+            const account_id_type id = ids[ ( size_t(s) * modifies_per_session + m * 7 ) % ids.size() ];
+            db.modify( id(db), [s]( account_object& a ) { a.referrer_rewards_percentage = s; } );
+            ++modified;
+         }
+         if( s % 10 == 9 )
+            session.undo();
+         else
+            session.commit();
+      }
+      const auto elapsed = fc::time_point::now() - start_time;
+      ilog( "${n} modifies in ${s} sessions took ${ms} milliseconds, ${ns} ns per modify, ${f} free slabs at the end",
+            ("n", modified)("s", session_count)("ms", elapsed.count() / 1000)
+            ("ns", elapsed.count() * 1000 / modified)("f", db._undo_db.free_slabs()) );
+
+      // popping runs the same state copies back through the indices
+      const auto pop_start = fc::time_point::now();
+      const size_t states = db._undo_db.size();
+      while( db._undo_db.size() > 0 )
+         db._undo_db.pop_commit();
+      ilog( "Popped ${n} states in ${ms} milliseconds",
+            ("n", states)("ms", (fc::time_point::now() - pop_start).count() / 1000) );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/global_property_object.hpp>
+#include <graphene/chain/license_objects.hpp>
+#include <graphene/chain/upgrade_event_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+#include <algorithm>
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+namespace {
+
+void create_unlicensed_accounts( database& db, uint32_t count )
+{
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      db.create<account_object>( [&]( account_object& a ) {
+         a.kind = account_kind::wallet;
+         a.name = "bench-" + fc::to_string( uint64_t( a.id.instance() ) );
+         a.statistics = db.create<account_statistics_object>( [&a]( account_statistics_object& s ) {
+            s.owner = a.id;
+            s.name = a.name;
+         } ).id;
+         a.owner.weight_threshold = 1;
+         a.active.weight_threshold = 1;
+         a.registrar = a.lifetime_referrer = a.referrer = GRAPHENE_COMMITTEE_ACCOUNT;
+      } );
+   }
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE( upgrade_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t unlicensed_count = 500000;
+      const uint32_t licensed_count = 1000;
+#else
+      const uint32_t unlicensed_count = 20000;
+      const uint32_t licensed_count = 100;
+#endif
+      const auto standard_locked = *_dal.get_license_type( "standard_locked" );
+      const time_point_sec issue_time = db.head_block_time();
+      for( uint32_t i = 0; i < licensed_count; ++i )
+      {
+         const auto& vault = create_new_vault_account( get_registrar_id(), "licensed-" + fc::to_string( uint64_t( i ) ) );
+         push_op_no_balance_check( issue_license_operation( get_license_issuer_id(), vault.id, standard_locked.id,
+                                                            0, 100, issue_time ) );
+      }
+      generate_block();
+      create_unlicensed_accounts( db, unlicensed_count );
+
+      const auto& dgpo = db.get_dynamic_global_properties();
+      const auto execution_time = dgpo.next_maintenance_time;
+      do_op( create_upgrade_event_operation( get_license_administrator_id(), execution_time, {}, {}, "bench" ) );
+      db.get_block_profiler().set_enabled( true );
+      generate_blocks( execution_time );
+      ilog( "license index, ${l} licensed vaults among ${a} accounts: maintenance ${t} us",
+            ("l", licensed_count)("a", unlicensed_count + licensed_count)
+            ("t", db.get_block_profiler().get_last_block().phases["maintenance"]) );
+
+      // the lookups of the sweep over every account by name that the license index replaced
+      const auto upgrade_id = db.get_index_type<upgrade_event_index>().indices().get<by_id>().rbegin()->get_id();
+      uint32_t upgraded = 0;
+      auto start = fc::time_point::now();
+      for( const auto& account : db.get_index_type<account_index>().indices().get<by_name>() )
+      {
+         if( !account.license_information.valid() )
+            continue;
+         for( const auto& record : (*account.license_information)( db ).history )
+            if( std::find_if( record.upgrades.begin(), record.upgrades.end(),
+                              [&]( const pair<upgrade_event_id_type, time_point_sec>& u ) { return u.first == upgrade_id; } )
+                != record.upgrades.end() )
+               ++upgraded;
+      }
+      ilog( "all-accounts sweep, lookups only: ${t} us, ${u} records upgraded",
+            ("t", (fc::time_point::now() - start).count())("u", upgraded) );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,87 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/global_property_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+namespace {
+
+void create_voters( database& db, uint32_t count, const vector<vote_id_type>& votes )
+{
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      const account_object& voter = db.create<account_object>( [&]( account_object& a ) {
+         a.name = "bench-" + fc::to_string( uint64_t( a.id.instance() ) );
+         a.statistics = db.create<account_statistics_object>( [&a]( account_statistics_object& s ) {
+            s.owner = a.id;
+            s.name = a.name;
+         } ).id;
+         a.owner.weight_threshold = 1;
+         a.active.weight_threshold = 1;
+         a.registrar = a.lifetime_referrer = a.referrer = GRAPHENE_COMMITTEE_ACCOUNT;
+         a.options.voting_account = GRAPHENE_PROXY_TO_SELF_ACCOUNT;
+         a.options.votes.insert( votes[i % votes.size()] );
+      } );
+      db.adjust_balance( voter.get_id(), asset( 1 + i % 1000 ) );
+   }
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE( vote_tally_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t voter_count = 1000000;
+#else
+      const uint32_t voter_count = 50000;
+#endif
+      vector<vote_id_type> votes;
+      for( const auto& member : db.get_global_properties().active_committee_members )
+         votes.push_back( member( db ).vote_id );
+      create_voters( db, voter_count, votes );
+      db.get_block_profiler().set_enabled( true );
+
+      for( uint32_t threads : { 1, 2, 4, 0 } )
+      {
+         db.set_maintenance_threads( threads );
+         generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+         ilog( "maintenance of ${v} voters, ${n} threads (0 is one per core): ${t} us",
+               ("v", voter_count)("n", threads)("t", db.get_block_profiler().get_last_block().phases["maintenance"]) );
+      }
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
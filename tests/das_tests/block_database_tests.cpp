@@ -0,0 +1,454 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/block_database.hpp>
+#include <graphene/chain/segmented_block_log.hpp>
+#include <graphene/chain/exceptions.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include <graphene/net/core_messages.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <fstream>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+BOOST_AUTO_TEST_SUITE( dascoin_tests )
+BOOST_AUTO_TEST_SUITE( block_database_tests )
+
+BOOST_AUTO_TEST_CASE( block_database_mmap_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database_options options;
+      options.memory_mapped = true;
+
+      block_database bdb;
+      bdb.open( data_dir.path(), options );
+      FC_ASSERT( bdb.is_open() );
+      FC_ASSERT( !bdb.fetch_by_number( 1 ).valid() );
+
+      signed_block b;
+      vector<block_id_type> ids;
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+
+         // every store grows both files past the current mapping
+         auto fetch = bdb.fetch_by_number( b.block_num() );
+         FC_ASSERT( fetch.valid() );
+         FC_ASSERT( fetch->witness == b.witness );
+         fetch = bdb.fetch_optional( b.id() );
+         FC_ASSERT( fetch.valid() );
+         FC_ASSERT( fetch->witness == b.witness );
+         FC_ASSERT( bdb.contains( b.id() ) );
+         FC_ASSERT( bdb.fetch_block_id( b.block_num() ) == b.id() );
+      }
+      FC_ASSERT( !bdb.fetch_by_number( 6 ).valid() );
+
+      bdb.remove( ids.back() );
+      FC_ASSERT( !bdb.contains( ids.back() ) );
+      FC_ASSERT( bdb.last_id().valid() && *bdb.last_id() == ids[3] );
+
+      bdb.close();
+      bdb.open( data_dir.path(), options );
+      for( uint32_t i = 1; i < 5; ++i )
+      {
+         auto blk = bdb.fetch_by_number( i );
+         FC_ASSERT( blk.valid() );
+         FC_ASSERT( blk->id() == ids[i-1] );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_raw_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      signed_block b;
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         bdb.store( b.id(), b );
+
+         auto raw = bdb.fetch_raw( b.block_num() );
+         FC_ASSERT( raw.valid() );
+         FC_ASSERT( *raw == fc::raw::pack( b ) );
+         raw = bdb.fetch_raw_optional( b.id() );
+         FC_ASSERT( raw.valid() );
+         FC_ASSERT( *raw == fc::raw::pack( b ) );
+
+         // the wire message built from stored bytes matches the one built from the block
+         graphene::net::message msg = graphene::net::block_message::from_packed_block( std::move( *raw ), b.id() );
+         FC_ASSERT( msg.data == graphene::net::message( graphene::net::block_message( b ) ).data );
+         FC_ASSERT( graphene::net::block_message::block_id_from_message( msg ) == b.id() );
+      }
+      FC_ASSERT( !bdb.fetch_raw( 6 ).valid() );
+      FC_ASSERT( !bdb.fetch_raw_optional( block_id_type() ).valid() );
+
+      bdb.remove( b.id() );
+      FC_ASSERT( !bdb.fetch_raw_optional( b.id() ).valid() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_segmented_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      // start with the single-file layout, it must be imported on the segmented open
+      signed_block b;
+      vector<block_id_type> ids;
+      {
+         block_database legacy;
+         legacy.open( data_dir.path() );
+         for( uint32_t i = 0; i < 3; ++i )
+         {
+            if( i > 0 ) b.previous = b.id();
+            b.witness = witness_id_type(i+1);
+            legacy.store( b.id(), b );
+            ids.push_back( b.id() );
+         }
+      }
+
+      block_database_options options;
+      options.segmented = true;
+      options.blocks_per_segment = 4;
+
+      block_database bdb;
+      bdb.open( data_dir.path(), options );
+      FC_ASSERT( !fc::exists( data_dir.path() / "index" ) );
+      FC_ASSERT( bdb.last_id().valid() && *bdb.last_id() == ids.back() );
+
+      for( uint32_t i = 3; i < 10; ++i )
+      {
+         b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+      }
+
+      // replace block 6 as a fork switch would, leaving dead bytes in segment 1
+      signed_block fork_block = *bdb.fetch_by_number( 6 );
+      bdb.remove( ids[5] );
+      FC_ASSERT( !bdb.contains( ids[5] ) );
+      FC_ASSERT( !bdb.fetch_raw( 6 ).valid() );
+      fork_block.timestamp += 1;
+      bdb.store( fork_block.id(), fork_block );
+      ids[5] = fork_block.id();
+
+      for( uint32_t i = 1; i <= 10; ++i )
+      {
+         auto blk = bdb.fetch_by_number( i );
+         FC_ASSERT( blk.valid() );
+         FC_ASSERT( blk->id() == ids[i-1] );
+         FC_ASSERT( bdb.contains( ids[i-1] ) );
+         FC_ASSERT( bdb.fetch_block_id( i ) == ids[i-1] );
+         auto raw = bdb.fetch_raw_optional( ids[i-1] );
+         FC_ASSERT( raw.valid() && *raw == fc::raw::pack( *blk ) );
+      }
+      FC_ASSERT( !bdb.fetch_by_number( 11 ).valid() );
+
+      bdb.close();
+
+      // compaction keeps the live blocks and survives a reopen
+      {
+         graphene::chain::segmented_block_log log( data_dir.path() / "segments", 4, true );
+         FC_ASSERT( log.compact_segment( 1 ) );
+         log.wait_for_compaction();
+      }
+
+      bdb.open( data_dir.path(), options );
+      for( uint32_t i = 1; i <= 10; ++i )
+      {
+         auto blk = bdb.fetch_by_number( i );
+         FC_ASSERT( blk.valid() );
+         FC_ASSERT( blk->id() == ids[i-1] );
+      }
+      FC_ASSERT( bdb.last_id().valid() && *bdb.last_id() == ids.back() );
+      FC_ASSERT( bdb.last()->id() == ids.back() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_interrupted_import_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      const fc::path segments_dir = data_dir.path() / "segments";
+      const fc::path import_dir = data_dir.path() / "segments.import";
+      const fc::path imported_index = data_dir.path() / "index.imported";
+
+      vector<signed_block> blocks;
+      signed_block b;
+      for( uint32_t i = 0; i < 6; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         blocks.push_back( b );
+      }
+
+      auto write_single_file_log = [&]() {
+         fc::remove_all( data_dir.path() );
+         block_database legacy;
+         legacy.open( data_dir.path() );
+         for( const signed_block& blk : blocks )
+            legacy.store( blk.id(), blk );
+      };
+      auto write_segments = [&]( const fc::path& dir, size_t count ) {
+         graphene::chain::segmented_block_log segments( dir, 4, false );
+         for( size_t i = 0; i < count; ++i )
+            segments.store( blocks[i].id(), fc::raw::pack( blocks[i] ) );
+         segments.flush();
+      };
+
+      block_database_options options;
+      options.segmented = true;
+      options.blocks_per_segment = 4;
+
+      auto open_and_check = [&]() {
+         block_database bdb;
+         bdb.open( data_dir.path(), options );
+         FC_ASSERT( !fc::exists( data_dir.path() / "index" ) );
+         FC_ASSERT( !fc::exists( data_dir.path() / "blocks" ) );
+         FC_ASSERT( !fc::exists( imported_index ) );
+         FC_ASSERT( !fc::exists( import_dir ) );
+         for( uint32_t i = 1; i <= blocks.size(); ++i )
+         {
+            auto blk = bdb.fetch_by_number( i );
+            FC_ASSERT( blk.valid() );
+            FC_ASSERT( blk->id() == blocks[i-1].id() );
+         }
+         FC_ASSERT( bdb.last_id().valid() && *bdb.last_id() == blocks.back().id() );
+      };
+
+      // stopped while copying: the partial copy is discarded and the import runs again
+      write_single_file_log();
+      write_segments( import_dir, 2 );
+      open_and_check();
+
+      // stopped after the index was renamed: the copy is complete and is moved into place
+      write_single_file_log();
+      write_segments( import_dir, blocks.size() );
+      fc::rename( data_dir.path() / "index", imported_index );
+      open_and_check();
+
+      // stopped after the copy was moved into place: only the old files are left to delete
+      write_single_file_log();
+      write_segments( segments_dir, blocks.size() );
+      fc::rename( data_dir.path() / "index", imported_index );
+      open_and_check();
+
+      // both layouts holding blocks without an import in progress is an error
+      write_single_file_log();
+      write_segments( segments_dir, 1 );
+      {
+         block_database bdb;
+         GRAPHENE_REQUIRE_THROW( bdb.open( data_dir.path(), options ), fc::exception );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_prune_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database_options options;
+      options.segmented = true;
+      options.blocks_per_segment = 4;
+      options.retain_blocks = 5;
+
+      block_database bdb;
+      bdb.open( data_dir.path(), options );
+      FC_ASSERT( bdb.first_block_num() == 1 );
+
+      signed_block b;
+      vector<block_id_type> ids;
+      for( uint32_t i = 0; i < 12; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+      }
+
+      // segments 0 and 1 hold blocks 1 to 7, segment 2 starts at block 8 and is kept whole
+      bdb.prune( 9 );
+      FC_ASSERT( bdb.first_block_num() == 8 );
+      FC_ASSERT( !bdb.fetch_by_number( 7 ).valid() );
+      FC_ASSERT( !bdb.contains( ids[6] ) );
+      for( uint32_t i = 8; i <= 12; ++i )
+         FC_ASSERT( bdb.fetch_by_number( i ).valid() );
+
+      bdb.close();
+      bdb.open( data_dir.path(), options );
+      FC_ASSERT( bdb.first_block_num() == 8 );
+      FC_ASSERT( bdb.last_id().valid() && *bdb.last_id() == ids.back() );
+      bdb.close();
+
+      // pruning needs the segmented layout
+      options.segmented = false;
+      GRAPHENE_REQUIRE_THROW( bdb.open( data_dir.path(), options ), fc::exception );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( block_log_prune_on_irreversible_test, database_fixture )
+{
+   try {
+      fc::temp_directory pruned_dir( graphene::utilities::temp_directory_path() );
+
+      block_database_options options;
+      options.segmented = true;
+      options.blocks_per_segment = 4;
+      options.retain_blocks = 10;
+
+      database pruned_db;
+      pruned_db.set_block_database_options( options );
+      pruned_db.open( pruned_dir.path(), [this]{ return genesis_state; }, "test" );
+
+      for( uint32_t i = 0; i < 60; ++i )
+      {
+         const uint32_t first = pruned_db.first_stored_block_num();
+         pruned_db.generate_block( pruned_db.get_slot_time(1), pruned_db.get_scheduled_witness(1),
+                                   init_account_priv_key, database::skip_undo_history_check );
+         // the log is only pruned up to the last irreversible block, and never below the retained window
+         const auto& dpo = pruned_db.get_dynamic_global_properties();
+         BOOST_CHECK_GE( pruned_db.first_stored_block_num(), first );
+         BOOST_CHECK_LE( pruned_db.first_stored_block_num(), dpo.last_irreversible_block_num + 1 );
+         BOOST_CHECK_LE( pruned_db.first_stored_block_num() + options.retain_blocks, dpo.head_block_number + 1 );
+      }
+
+      const uint32_t first = pruned_db.first_stored_block_num();
+      BOOST_CHECK_GT( first, 1u );
+      BOOST_CHECK( pruned_db.fetch_block_by_number( first ).valid() );
+      BOOST_CHECK( !pruned_db.fetch_block_by_number( first - 1 ).valid() );
+      pruned_db.close();
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( snapshot_test, database_fixture )
+{
+   try {
+      fc::temp_directory source_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory restored_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory snapshot_dir( graphene::utilities::temp_directory_path() );
+      const fc::path snapshot_file = snapshot_dir.path() / "state.snapshot";
+      const auto genesis_loader = [this]{ return genesis_state; };
+
+      block_id_type irreversible_id;
+      fc::sha256 irreversible_hash;
+      {
+         database source;
+         source.open( source_dir.path(), genesis_loader, "test" );
+         for( uint32_t i = 0; i < 20; ++i )
+            source.generate_block( source.get_slot_time(1), source.get_scheduled_witness(1), init_account_priv_key,
+                                   database::skip_nothing );
+
+         // the snapshot holds the state at the last irreversible block, not at the head block
+         const uint32_t irreversible_num = source.get_dynamic_global_properties().last_irreversible_block_num;
+         BOOST_REQUIRE_LT( irreversible_num, source.head_block_num() );
+         const auto irreversible_hashes = source.get_state_hashes( irreversible_num );
+         BOOST_REQUIRE( irreversible_hashes.valid() );
+         irreversible_id = irreversible_hashes->block_id;
+         irreversible_hash = irreversible_hashes->state_hash;
+         const block_id_type head_id = source.head_block_id();
+         const fc::sha256 head_hash = source.get_state_hash();
+
+         source.create_snapshot( snapshot_file );
+         // the blocks popped to take it are applied again
+         BOOST_CHECK( source.head_block_id() == head_id );
+         BOOST_CHECK( source.get_state_hash() == head_hash );
+         source.close();
+      }
+      {
+         database restored;
+         BOOST_CHECK( restored.import_snapshot( snapshot_file, restored_dir.path(), "test" ) );
+         restored.open( restored_dir.path(), genesis_loader, "test" );
+         BOOST_CHECK( restored.head_block_id() == irreversible_id );
+         BOOST_CHECK( restored.get_state_hash() == irreversible_hash );
+
+         // the restored node carries on from the snapshot's head block
+         restored.generate_block( restored.get_slot_time(1), restored.get_scheduled_witness(1), init_account_priv_key,
+                                  database::skip_nothing );
+         BOOST_CHECK_EQUAL( restored.head_block_num(), block_header::num_from_id(irreversible_id) + 1 );
+         restored.close();
+      }
+      {
+         // importing again, as with the option left in the config, leaves the state built since alone
+         database restored;
+         BOOST_CHECK( !restored.import_snapshot( snapshot_file, restored_dir.path(), "test" ) );
+         restored.open( restored_dir.path(), genesis_loader, "test" );
+         BOOST_CHECK_EQUAL( restored.head_block_num(), block_header::num_from_id(irreversible_id) + 1 );
+         restored.close();
+      }
+      {
+         fc::temp_directory empty_dir( graphene::utilities::temp_directory_path() );
+         database db;
+         GRAPHENE_REQUIRE_THROW( db.import_snapshot( snapshot_file, empty_dir.path(), "other" ), fc::exception );
+
+         // flip one byte, the checksum has to catch it
+         std::fstream f( snapshot_file.generic_string(), std::ios::in | std::ios::out | std::ios::binary );
+         f.seekg( 100 );
+         const char c = f.get();
+         f.seekp( 100 );
+         f.put( ~c );
+         f.close();
+         GRAPHENE_REQUIRE_THROW( db.import_snapshot( snapshot_file, empty_dir.path(), "test" ), fc::exception );
+      }
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()  // dascoin_tests::block_database_tests
+BOOST_AUTO_TEST_SUITE_END()  // dascoin_tests
@@ -0,0 +1,262 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/block_database.hpp>
+#include <graphene/chain/block_prefetcher.hpp>
+#include <graphene/chain/exceptions.hpp>
+#include <graphene/chain/protocol/block.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+BOOST_FIXTURE_TEST_SUITE( dascoin_tests, database_fixture )
+
+BOOST_FIXTURE_TEST_SUITE( block_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( block_digests_test )
+{ try {
+   ACTORS((alice)(bob)(carol));
+   generate_block();
+
+   const auto block = db.fetch_block_by_number( db.head_block_num() );
+   BOOST_REQUIRE( block.valid() );
+   BOOST_REQUIRE( !block->transactions.empty() );
+
+   const block_digests digests( *block );
+   BOOST_CHECK( digests.id == block->id() );
+   BOOST_CHECK( digests.id == db.head_block_id() );
+   BOOST_REQUIRE( digests.merkle_root.valid() );
+   BOOST_CHECK( *digests.merkle_root == block->calculate_merkle_root() );
+   BOOST_CHECK( *digests.merkle_root == block->transaction_merkle_root );
+   BOOST_REQUIRE_EQUAL( digests.transaction_ids.size(), block->transactions.size() );
+   for( size_t i = 0; i < block->transactions.size(); ++i )
+   {
+      BOOST_CHECK( digests.transaction_ids[i] == block->transactions[i].id() );
+      BOOST_CHECK( db.is_known_transaction( digests.transaction_ids[i] ) );
+   }
+   BOOST_CHECK( !block_digests( *block, false ).merkle_root.valid() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( block_prefetcher_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      signed_block b;
+      vector<signed_block> blocks;
+      for( uint32_t i = 0; i < 10; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.transactions.clear();
+         for( uint16_t t = 0; t <= i % 3; ++t )
+         {
+            signed_transaction trx;
+            trx.ref_block_num = i;
+            trx.ref_block_prefix = t;
+            b.transactions.emplace_back( trx );
+         }
+         b.transaction_merkle_root = b.calculate_merkle_root();
+         bdb.store( b.id(), b );
+         blocks.push_back( b );
+      }
+      bdb.remove( blocks[6].id() );
+
+      {
+         block_prefetcher prefetcher( bdb, 1, 6, 2 );
+         for( uint32_t num = 1; num <= 6; ++num )
+         {
+            optional<prefetched_block> next = prefetcher.next();
+            BOOST_REQUIRE( next.valid() );
+            const signed_block& expected = blocks[num - 1];
+            BOOST_CHECK( next->block.id() == expected.id() );
+            BOOST_CHECK( next->digests.id == expected.id() );
+            BOOST_REQUIRE( next->digests.merkle_root.valid() );
+            BOOST_CHECK( *next->digests.merkle_root == expected.transaction_merkle_root );
+            BOOST_REQUIRE_EQUAL( next->digests.transaction_ids.size(), expected.transactions.size() );
+            for( size_t t = 0; t < expected.transactions.size(); ++t )
+               BOOST_CHECK( next->digests.transaction_ids[t] == expected.transactions[t].id() );
+         }
+         GRAPHENE_REQUIRE_THROW( prefetcher.next(), fc::exception );
+      }
+
+      {
+         // the reader stops at the missing block 7
+         block_prefetcher prefetcher( bdb, 5, 10, 1, false );
+         BOOST_CHECK( prefetcher.next().valid() );
+         optional<prefetched_block> next = prefetcher.next();
+         BOOST_REQUIRE( next.valid() );
+         BOOST_CHECK( !next->digests.merkle_root.valid() );
+         BOOST_CHECK( !prefetcher.next().valid() );
+         GRAPHENE_REQUIRE_THROW( prefetcher.next(), fc::exception );
+      }
+
+      {
+         // destroying a prefetcher with a full queue stops its reader
+         block_prefetcher prefetcher( bdb, 1, 6, 1 );
+         BOOST_CHECK( prefetcher.next().valid() );
+      }
+
+      bdb.close();
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( replay_verify_signatures )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      const auto genesis_loader = [this]{ return genesis_state; };
+      chain_id_type chain_id;
+      uint32_t signed_block_num;
+      {
+         database db;
+         db.open(data_dir.path(), genesis_loader, "TEST" );
+         chain_id = db.get_chain_id();
+         // more blocks than the undo window, so the signed one is replayed through the prefetcher
+         for( uint32_t i = 0; i < 80; ++i )
+         {
+            if( i == 5 )
+            {
+               assert_operation op;
+               op.fee_paying_account = db.get_index_type<account_index>().indices().get<by_name>().find( "init0" )->id;
+               signed_transaction trx;
+               trx.operations.push_back( op );
+               trx.set_expiration( db.head_block_time() + fc::seconds( 60 ) );
+               trx.set_reference_block( db.head_block_id() );
+               trx.sign( init_account_priv_key, chain_id );
+               db.push_transaction( trx );
+            }
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+            if( i == 5 )
+               signed_block_num = db.head_block_num();
+         }
+         db.close();
+      }
+
+      {
+         database db;
+         db.set_replay_verify_signatures( true );
+         db.open(data_dir.path(), genesis_loader, "TEST_VERIFY" );
+         BOOST_CHECK_GT( db.head_block_num(), signed_block_num );
+         db.close();
+      }
+
+      {
+         // a transaction signature is not part of the block id or merkle root, so only verifying notices the swap
+         block_database bdb;
+         bdb.open( data_dir.path() / "database" / "block_num_to_block" );
+         signed_block b = *bdb.fetch_by_number( signed_block_num );
+         BOOST_REQUIRE_EQUAL( b.transactions.size(), 1u );
+         const block_id_type id = b.id();
+         b.transactions[0].signatures.clear();
+         b.transactions[0].sign( fc::ecc::private_key::regenerate(fc::sha256::hash(string("other_key"))), chain_id );
+         BOOST_REQUIRE( b.id() == id );
+         bdb.store( id, b );
+         bdb.close();
+      }
+
+      {
+         database db;
+         db.open(data_dir.path(), genesis_loader, "TEST_TRUST" );
+         BOOST_CHECK_GT( db.head_block_num(), signed_block_num );
+         db.close();
+      }
+      {
+         database db;
+         db.set_replay_verify_signatures( true );
+         GRAPHENE_REQUIRE_THROW( db.open(data_dir.path(), genesis_loader, "TEST_VERIFY_AGAIN" ), fc::exception );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_profiler_test )
+{ try {
+   block_profiler& profiler = db.get_block_profiler();
+   // disabled, applying a block records nothing
+   generate_block();
+   BOOST_CHECK_EQUAL( profiler.get_stats().blocks, 0u );
+
+   profiler.set_enabled( true );
+   profiler.set_window_blocks( 2 );
+   ACTORS((alice));
+   generate_block();
+
+   block_profile_stats stats = profiler.get_stats();
+   BOOST_CHECK_EQUAL( stats.blocks, 1u );
+   BOOST_CHECK_EQUAL( stats.total.count, 1u );
+   BOOST_REQUIRE( stats.phases.count( "transactions" ) );
+   BOOST_CHECK_EQUAL( stats.phases["transactions"].count, 1u );
+   BOOST_CHECK_LE( stats.phases["transactions"].total_ns, stats.total.total_ns );
+   BOOST_REQUIRE( stats.evaluate.count( "account_create_operation" ) );
+   BOOST_CHECK_EQUAL( stats.evaluate["account_create_operation"].count, 1u );
+   BOOST_CHECK_EQUAL( stats.apply["account_create_operation"].count, 1u );
+   uint64_t bucketed = 0;
+   for( uint64_t n : stats.total.buckets )
+      bucketed += n;
+   BOOST_CHECK_EQUAL( bucketed, 1u );
+
+   const block_profile last = profiler.get_last_block();
+   BOOST_CHECK_EQUAL( last.block_num, db.head_block_num() );
+   BOOST_CHECK( last.operations.count( "account_create_operation" ) );
+   BOOST_CHECK_EQUAL( last.phases.size(), size_t( phase_count ) );
+
+   // the window of the block with the account creation rolls out after two more windows
+   generate_blocks( 3 );
+   stats = profiler.get_stats();
+   BOOST_CHECK_EQUAL( stats.blocks, 2u );
+   BOOST_CHECK_EQUAL( stats.total.count, 2u );
+   BOOST_CHECK( !stats.evaluate.count( "account_create_operation" ) );
+
+   // a block that fails to apply is discarded and does not leave the profiler recording
+   signed_block bad;
+   bad.previous = db.head_block_id();
+   bad.timestamp = db.get_slot_time( 1 );
+   bad.witness = db.get_scheduled_witness( 1 );
+   bad.transaction_merkle_root = checksum_type::hash( string( "not the merkle root" ) );
+   GRAPHENE_REQUIRE_THROW( db.push_block( bad ), fc::exception );
+   BOOST_CHECK( !profiler.recording() );
+   BOOST_CHECK_EQUAL( profiler.get_last_block().block_num, db.head_block_num() );
+   generate_block();
+   BOOST_CHECK_EQUAL( profiler.get_last_block().block_num, db.head_block_num() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()  // dascoin_tests::block_tests
+
+BOOST_AUTO_TEST_SUITE_END()  // dascoin_tests
@@ -162,6 +162,120 @@ BOOST_AUTO_TEST_CASE( delayed_operations_index_test )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( delayed_operations_due_time_test )
+{ try {
+  ACTORS((wa1)(wa2)(wa3));
+
+  do_op(update_delayed_operations_resolver_parameters_operation(db.get_global_properties().authorities.root_administrator, true, 600));
+
+  // All three are due, wa2 first and wa1 last:
+  const auto issued_time = db.head_block_time() - fc::seconds(1000);
+  const asset nothing{ 0, db.get_dascoin_asset_id() };
+  db.create<delayed_operation_object>([&](delayed_operation_object& dlo){
+    dlo.account = wa1_id;
+    dlo.issued_time = issued_time;
+    dlo.skip = 300;
+    dlo.op = unreserve_asset_on_account_operation{wa1_id, nothing};
+  });
+  db.create<delayed_operation_object>([&](delayed_operation_object& dlo){
+    dlo.account = wa2_id;
+    dlo.issued_time = issued_time;
+    dlo.skip = 100;
+    dlo.op = unreserve_asset_on_account_operation{wa2_id, nothing};
+  });
+  db.create<delayed_operation_object>([&](delayed_operation_object& dlo){
+    dlo.account = wa3_id;
+    dlo.issued_time = issued_time;
+    dlo.skip = 200;
+    dlo.op = unreserve_asset_on_account_operation{wa3_id, nothing};
+  });
+
+  // Resolve one operation per block:
+  db.modify(db.get_global_properties(), [](global_property_object& gpo){
+    delayed_operations_resolver_batch_type batch;
+    batch.operations_per_block = 1;
+    gpo.parameters.extensions.insert(batch);
+  });
+  db.modify(db.get_dynamic_global_properties(), [&](dynamic_global_property_object& dgpo){
+    dgpo.next_delayed_operations_resolver_time = db.head_block_time();
+  });
+
+  const auto& idx = db.get_index_type<delayed_operations_index>().indices().get<by_account>();
+  const auto pending = [&](account_id_type account){ return idx.count(boost::make_tuple(account)) > 0; };
+
+  generate_block();
+  BOOST_CHECK( pending(wa1_id) );
+  BOOST_CHECK( !pending(wa2_id) );
+  BOOST_CHECK( pending(wa3_id) );
+  // The rest is still due, so the resolver runs again in the next block:
+  BOOST_CHECK( db.get_dynamic_global_properties().next_delayed_operations_resolver_time == db.head_block_time() );
+
+  generate_block();
+  BOOST_CHECK( pending(wa1_id) );
+  BOOST_CHECK( !pending(wa3_id) );
+
+  generate_block();
+  BOOST_CHECK( idx.empty() );
+  BOOST_CHECK( db.get_dynamic_global_properties().next_delayed_operations_resolver_time == db.head_block_time() + 600 );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( delayed_operations_large_pending_test )
+{ try {
+  do_op(update_delayed_operations_resolver_parameters_operation(db.get_global_properties().authorities.root_administrator, true, 600));
+
+  // One in ten is due now, the rest is due in a day:
+  const uint32_t pending_count = 5000;
+  const uint32_t due_count = pending_count / 10;
+  const asset nothing{ 0, db.get_dascoin_asset_id() };
+  for ( uint32_t i = 0; i < pending_count; ++i )
+  {
+    const account_id_type account( 1000000 + i );
+    db.create<delayed_operation_object>([&](delayed_operation_object& dlo){
+      dlo.account = account;
+      dlo.issued_time = db.head_block_time();
+      dlo.skip = i % 10 == 0 ? 0 : 86400;
+      dlo.op = unreserve_asset_on_account_operation{account, nothing};
+    });
+  }
+
+  const uint32_t operations_per_block = 200;
+  db.modify(db.get_global_properties(), [&](global_property_object& gpo){
+    delayed_operations_resolver_batch_type batch;
+    batch.operations_per_block = operations_per_block;
+    gpo.parameters.extensions.insert(batch);
+  });
+  db.modify(db.get_dynamic_global_properties(), [&](dynamic_global_property_object& dgpo){
+    dgpo.next_delayed_operations_resolver_time = db.head_block_time();
+  });
+
+  const auto& idx = db.get_index_type<delayed_operations_index>().indices().get<by_due_time>();
+  const auto count_due = [&](){
+    uint32_t due = 0;
+    for ( auto it = idx.begin(); it != idx.end() && it->due_time() <= db.head_block_time(); ++it )
+      ++due;
+    return due;
+  };
+  BOOST_CHECK_EQUAL( count_due(), due_count );
+
+  // Each block resolves the cap and nothing that is not due yet:
+  uint32_t left = due_count;
+  while ( left > 0 )
+  {
+    generate_block();
+    left -= std::min( left, operations_per_block );
+    BOOST_CHECK_EQUAL( count_due(), left );
+    BOOST_CHECK_EQUAL( idx.size(), pending_count - due_count + left );
+    const auto next_time = db.get_dynamic_global_properties().next_delayed_operations_resolver_time;
+    BOOST_CHECK( next_time == ( left > 0 ? db.head_block_time() : db.head_block_time() + 600 ) );
+  }
+
+  // Nothing else resolves before the rest is due:
+  generate_block();
+  BOOST_CHECK_EQUAL( idx.size(), pending_count - due_count );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( register_daspay_authority_test )
 { try {
   ACTORS((foo)(bar)(foobar)(payment));
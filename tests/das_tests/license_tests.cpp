@@ -630,6 +630,50 @@ BOOST_AUTO_TEST_CASE( upgrade_cycles_test )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( upgrade_subsequent_execution_test )
+{ try {
+  VAULT_ACTOR(foo);
+  VAULT_ACTOR(bar);
+  VAULT_ACTOR(unlicensed);
+
+  auto standard_locked = *(_dal.get_license_type("standard_locked"));
+  const share_type bonus_percent = 0;
+  const share_type frequency_lock = 100;
+  const time_point_sec issue_time = db.head_block_time();
+  const auto& dgpo = db.get_dynamic_global_properties();
+  const auto& gpo = db.get_global_properties();
+
+  do_op(issue_license_operation(get_license_issuer_id(), foo_id, standard_locked.id,
+                                bonus_percent, frequency_lock, issue_time));
+
+  const auto first_execution = dgpo.next_maintenance_time;
+  const auto second_execution = first_execution + 2 * gpo.parameters.maintenance_interval;
+  do_op(create_upgrade_event_operation(get_license_administrator_id(), first_execution,
+                                       first_execution, {second_execution}, "foo"));
+  const auto upgrade_id = db.get_index_type<upgrade_event_index>().indices().get<by_id>().begin()->get_id();
+
+  generate_blocks(first_execution);
+
+  const auto& foo_history = (*foo.license_information)(db).history;
+  BOOST_CHECK( foo_history[0].upgraded_by(upgrade_id) );
+  BOOST_CHECK_EQUAL( foo_history[0].upgrades.size(), 1 );
+  BOOST_CHECK_EQUAL( get_cycle_balance(foo_id).value, 2 * DASCOIN_BASE_STANDARD_CYCLES );
+  BOOST_CHECK( !unlicensed.license_information.valid() );
+  BOOST_CHECK_EQUAL( get_cycle_balance(unlicensed_id).value, 0 );
+
+  // Bar's license was activated before the cutoff time, so the second execution upgrades it, but not foo's again:
+  do_op(issue_license_operation(get_license_issuer_id(), bar_id, standard_locked.id,
+                                bonus_percent, frequency_lock, issue_time));
+  generate_blocks(second_execution);
+
+  const auto& bar_history = (*bar.license_information)(db).history;
+  BOOST_CHECK( bar_history[0].upgraded_by(upgrade_id) );
+  BOOST_CHECK_EQUAL( get_cycle_balance(bar_id).value, 2 * DASCOIN_BASE_STANDARD_CYCLES );
+  BOOST_CHECK_EQUAL( foo_history[0].upgrades.size(), 1 );
+  BOOST_CHECK_EQUAL( get_cycle_balance(foo_id).value, 2 * DASCOIN_BASE_STANDARD_CYCLES );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( upgrade_president_cycles_test )
 { try {
   VAULT_ACTOR(foo);
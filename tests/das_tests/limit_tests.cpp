@@ -240,6 +240,45 @@ BOOST_AUTO_TEST_CASE( limit_reset_test )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( spread_limit_reset_test )
+{ try {
+  const auto DASCOIN_ASSET_ID = get_dascoin_asset_id();
+  VAULT_ACTORS((first)(second)(third));
+
+  for ( const account_object* vault : { &first, &second, &third } )
+    db.adjust_balance_limit(*vault, DASCOIN_ASSET_ID, 1);
+
+  const auto& vaults = db.get_index_type<account_index>().indices().get<by_kind>();
+  const auto vault_count = std::distance(vaults.lower_bound(boost::make_tuple(account_kind::vault)),
+                                         vaults.upper_bound(boost::make_tuple(account_kind::vault)));
+
+  // Reset one vault per block:
+  db.modify(db.get_global_properties(), [](global_property_object& gpo){
+    spending_limit_reset_batch_type batch;
+    batch.accounts_per_block = 1;
+    gpo.parameters.extensions.insert(batch);
+  });
+
+  auto& dgp = db.get_dynamic_global_properties();
+  generate_blocks(dgp.next_spend_limit_reset);
+  int64_t blocks = 1;
+  while ( dgp.next_spend_limit_reset_account.valid() )
+  {
+    // The vaults are reset in id order, so the newest one is the last:
+    BOOST_CHECK_EQUAL( db.get_balance_object(third_id, DASCOIN_ASSET_ID).limit.value, 1 );
+    generate_block();
+    ++blocks;
+  }
+  BOOST_CHECK_EQUAL( blocks, vault_count );
+
+  const asset ADVOCATE_EUR_LIMIT =
+    {_dal.get_license_type("no_license")->eur_limit, get_web_asset_id()};
+  share_type expected_limit = (ADVOCATE_EUR_LIMIT * dgp.last_daily_dascoin_price).amount;
+  for ( const account_object* vault : { &first, &second, &third } )
+    BOOST_CHECK_EQUAL( db.get_balance_object(vault->get_id(), DASCOIN_ASSET_ID).limit.value, expected_limit.value );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( daily_dascoin_price_test )
 { try {
   const auto DSC_ID = get_dascoin_asset_id();
@@ -0,0 +1,76 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/committee_member_object.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+BOOST_FIXTURE_TEST_SUITE( dascoin_tests, database_fixture )
+
+BOOST_FIXTURE_TEST_SUITE( maintenance_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( parallel_vote_tally )
+{ try {
+   // Enough voters for the tally to be split over threads, with distinct stakes:
+   const auto& committee_member = db.get_global_properties().active_committee_members.front()(db);
+   const uint32_t voter_count = 10000;
+   for( uint32_t i = 1; i <= voter_count; ++i )
+   {
+      const account_object& voter = db.create<account_object>( [&]( account_object& a ) {
+         a.name = "voter-" + fc::to_string( uint64_t( i ) );
+         a.statistics = db.create<account_statistics_object>( [&a]( account_statistics_object& s ) {
+            s.owner = a.id;
+            s.name = a.name;
+         } ).id;
+         a.owner.weight_threshold = 1;
+         a.active.weight_threshold = 1;
+         a.registrar = a.lifetime_referrer = a.referrer = GRAPHENE_COMMITTEE_ACCOUNT;
+         a.options.voting_account = GRAPHENE_PROXY_TO_SELF_ACCOUNT;
+         a.options.votes.insert( committee_member.vote_id );
+      } );
+      db.adjust_balance( voter.get_id(), asset( i ) );
+   }
+
+   const auto tally_at_next_maintenance = [&]( uint32_t threads ) {
+      db.set_maintenance_threads( threads );
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+      generate_block();
+      return committee_member.total_votes;
+   };
+
+   const uint64_t sequential = tally_at_next_maintenance( 1 );
+   BOOST_CHECK_GE( sequential, uint64_t( voter_count ) * ( voter_count + 1 ) / 2 );
+   BOOST_CHECK_EQUAL( tally_at_next_maintenance( 4 ), sequential );
+   BOOST_CHECK_EQUAL( tally_at_next_maintenance( 0 ), sequential );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()  // dascoin_tests::maintenance_tests
+
+BOOST_AUTO_TEST_SUITE_END()  // dascoin_tests
@@ -0,0 +1,450 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/chain/transaction_object.hpp>
+
+#include <graphene/db/read_view.hpp>
+#include <graphene/db/worker_pool.hpp>
+
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+BOOST_FIXTURE_TEST_SUITE( dascoin_tests, database_fixture )
+
+BOOST_FIXTURE_TEST_SUITE( object_database_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( incremental_flush_test )
+{ try {
+   ACTOR(sam);
+   db.flush();
+
+   const fc::path dir = db.get_data_dir() / "object_database";
+   const fc::path account_file = dir / fc::to_string(account_object::space_id) / fc::to_string(account_object::type_id);
+   const fc::path asset_file = dir / fc::to_string(asset_object::space_id) / fc::to_string(asset_object::type_id);
+   const auto asset_generation = db.get_index_type<asset_index>().generation();
+   const auto account_generation = db.get_index_type<account_index>().generation();
+
+   db.modify( sam_id(db), []( account_object& a ) { a.name = "samuel"; } );
+   BOOST_CHECK( db.get_index_type<account_index>().generation() != account_generation );
+   BOOST_CHECK( db.get_index_type<asset_index>().generation() == asset_generation );
+
+   // an extra link shows whether the next flush links the unchanged file or writes a new one
+   const fc::path asset_link = db.get_data_dir() / "asset_index_link";
+   const fc::path account_link = db.get_data_dir() / "account_index_link";
+   fc::create_hard_link( asset_file, asset_link );
+   fc::create_hard_link( account_file, account_link );
+   db.flush();
+
+   BOOST_CHECK_EQUAL( boost::filesystem::hard_link_count( asset_file.generic_string() ), 2u );
+   BOOST_CHECK_EQUAL( boost::filesystem::hard_link_count( account_file.generic_string() ), 1u );
+   fc::remove( asset_link );
+   fc::remove( account_link );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( parallel_open_test )
+{ try {
+   ACTORS((alice)(bob)(carol));
+   generate_block();
+   db.flush();
+   const auto state_hash = db.get_state_hash();
+
+   // the indices read on several threads are inserted in the same order as when read on one
+   for( uint32_t threads : { 1u, 4u } )
+   {
+      database reopened;
+      reopened.set_io_threads( threads );
+      static_cast<object_database&>(reopened).open( db.get_data_dir() );
+      BOOST_CHECK( reopened.get_state_hash() == state_hash );
+      BOOST_CHECK_EQUAL( carol_id(reopened).name, "carol" );
+      BOOST_CHECK( !reopened.get_index_load_times().empty() );
+   }
+
+   graphene::db::worker_pool pool( 4 );
+   BOOST_CHECK_EQUAL( pool.size(), 4u );
+   std::vector<uint32_t> done( 100, 0 );
+   pool.run( done.size(), [&done]( size_t i ) { ++done[i]; } );
+   BOOST_CHECK( std::all_of( done.begin(), done.end(), []( uint32_t n ) { return n == 1; } ) );
+   GRAPHENE_REQUIRE_THROW( pool.run( 10, []( size_t i ) { FC_ASSERT( i != 5 ); } ), fc::exception );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( index_file_format_test )
+{ try {
+   ACTORS((alice)(bob));
+   db.flush();
+   const auto& accounts = db.get_index_type< primary_index<account_index> >();
+
+   // the account index in the format from before the framing, each object packed twice
+   fc::temp_directory legacy_dir( graphene::utilities::temp_directory_path() );
+   {
+      const fc::path dir = legacy_dir.path() / "object_database" / fc::to_string(account_object::space_id);
+      fc::create_directories( dir );
+      std::ofstream out( (dir / fc::to_string(account_object::type_id)).generic_string(), std::ofstream::binary );
+      fc::raw::pack( out, accounts.get_next_id() );
+      fc::raw::pack( out, accounts.get_object_version() );
+      accounts.inspect_all_objects( [&]( const object& o ) {
+         auto packed = fc::raw::pack( fc::raw::pack( static_cast<const account_object&>(o) ) );
+         out.write( packed.data(), packed.size() );
+      });
+   }
+
+   for( const fc::path& dir : { db.get_data_dir(), legacy_dir.path() } )
+   {
+      database reopened;
+      static_cast<object_database&>(reopened).open( dir );
+      const auto& reopened_accounts = reopened.get_index_type<account_index>();
+      BOOST_CHECK( reopened_accounts.get_next_id() == accounts.get_next_id() );
+      BOOST_CHECK_EQUAL( reopened_accounts.indices().size(), accounts.indices().size() );
+      for( const auto& a : accounts.indices() )
+         BOOST_CHECK( fc::raw::pack( a ) == fc::raw::pack( account_id_type(a.id)(reopened) ) );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( state_journal_test )
+{ try {
+   fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+   const fc::path journal_file = data_dir.path() / "object_database.journal";
+
+   database journaled;
+   journaled.set_journal_enabled( true );
+   static_cast<object_database&>(journaled).open( data_dir.path() );
+   const account_id_type alice = journaled.create<account_object>( []( account_object& a ) { a.name = "alice"; } ).id;
+   const account_id_type bob = journaled.create<account_object>( []( account_object& a ) { a.name = "bob"; } ).id;
+   journaled.journal_commit( 1, 1 );
+   journaled.modify( alice(journaled), []( account_object& a ) { a.name = "alice2"; } );
+   journaled.remove( bob(journaled) );
+   // re-created under a new id, the removal has to be replayed before the unique name is taken again
+   const account_id_type carol = journaled.create<account_object>( []( account_object& a ) { a.name = "bob"; } ).id;
+   journaled.journal_commit( 2, 2 );
+   const auto next_id = journaled.get_index_type<account_index>().get_next_id();
+   const auto state_hash = journaled.get_state_hash();
+   // past the last irreversible block, recovery has to leave this one to the block log
+   journaled.modify( alice(journaled), []( account_object& a ) { a.name = "alice3"; } );
+   journaled.journal_commit( 3, 2 );
+   {
+      // a record cut off by the crash
+      std::ofstream out( journal_file.generic_string(), std::ofstream::binary | std::ofstream::app );
+      out.write( "\x40\0\0\0torn", 8 );
+   }
+
+   // the process dies here, nothing was flushed
+   {
+      database recovered;
+      recovered.set_journal_enabled( true );
+      static_cast<object_database&>(recovered).open( data_dir.path() );
+      BOOST_CHECK_EQUAL( alice(recovered).name, "alice2" );
+      BOOST_CHECK( recovered.find( bob ) == nullptr );
+      BOOST_CHECK_EQUAL( carol(recovered).name, "bob" );
+      BOOST_CHECK( recovered.get_index_type<account_index>().get_next_id() == next_id );
+      BOOST_CHECK( recovered.get_state_hash() == state_hash );
+
+      // once flushed the journal starts over and the same state opens without it
+      recovered.flush();
+      recovered.close();
+   }
+   BOOST_CHECK_EQUAL( fc::file_size( journal_file ), 16u );
+   {
+      database reopened;
+      reopened.set_journal_enabled( true );
+      static_cast<object_database&>(reopened).open( data_dir.path() );
+      BOOST_CHECK_EQUAL( alice(reopened).name, "alice2" );
+      BOOST_CHECK( reopened.get_state_hash() == state_hash );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( journal_checkpoint_test )
+{ try {
+   fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+   const fc::path journal_file = data_dir.path() / "object_database.journal";
+   const auto genesis_loader = [this]{ return genesis_state; };
+   const uint32_t checkpoint_blocks = 5;
+
+   block_id_type head_id;
+   fc::sha256 state_hash;
+   {
+      database journaled;
+      journaled.set_journal_enabled( true );
+      journaled.set_journal_checkpoint_blocks( checkpoint_blocks );
+      journaled.open( data_dir.path(), genesis_loader, "test" );
+      // the checkpoints apply no block a second time
+      uint32_t applied = 0;
+      journaled.applied_block.connect( [&applied]( const signed_block& ) { ++applied; } );
+      for( uint32_t i = 0; i < 60; ++i )
+      {
+         journaled.generate_block( journaled.get_slot_time(1), journaled.get_scheduled_witness(1),
+                                   init_account_priv_key, database::skip_nothing );
+
+         // the checkpoints keep the journal to the blocks since the last one and the reversible ones
+         uint64_t base = 0;
+         std::ifstream in( ( data_dir.path() / "object_database" / "journal_base" ).generic_string() );
+         in >> base;
+         const auto records = graphene::db::state_journal::scan( journal_file, base );
+         const auto& dpo = journaled.get_dynamic_global_properties();
+         BOOST_CHECK_LE( records.size(), size_t( checkpoint_blocks + dpo.head_block_number - dpo.last_irreversible_block_num ) );
+      }
+      BOOST_CHECK_EQUAL( applied, 60u );
+      BOOST_CHECK( fc::exists( data_dir.path() / "object_database" / "journal_base" ) );
+      head_id = journaled.head_block_id();
+      state_hash = journaled.get_state_hash();
+      // the process dies here, without close()
+   }
+   {
+      // the flushed state and the journal on top of it take the node to the last irreversible block, the block log
+      // does the rest
+      database recovered;
+      recovered.set_journal_enabled( true );
+      recovered.open( data_dir.path(), genesis_loader, "test" );
+      BOOST_CHECK( recovered.head_block_id() == head_id );
+      BOOST_CHECK( recovered.get_state_hash() == state_hash );
+      recovered.close();
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( id_table_test )
+{ try {
+   // ids of a few types with clustered instances, so probe runs cross and wrap around
+   id_table< std::pair<object_id_type, uint64_t> > table;
+   std::map< object_id_type, uint64_t > expected;
+   uint64_t seed = 1;
+   for( uint32_t i = 0; i < 20000; ++i )
+   {
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      const object_id_type id( 1, ( seed >> 60 ) % 3, ( seed >> 33 ) % 500 );
+      if( ( seed >> 20 ) % 3 == 0 )
+         BOOST_CHECK_EQUAL( table.erase( id ), expected.erase( id ) );
+      else
+         expected[id] = table[id] = i;
+   }
+   BOOST_CHECK_EQUAL( table.size(), expected.size() );
+   size_t seen = 0;
+   for( const auto& item : table )
+   {
+      BOOST_REQUIRE( expected.count( item.first ) );
+      BOOST_CHECK_EQUAL( item.second, expected[item.first] );
+      ++seen;
+   }
+   BOOST_CHECK_EQUAL( seen, expected.size() );
+   for( const auto& item : expected )
+      BOOST_CHECK( table.find( item.first ) != table.end() );
+
+   id_table< object_id_type > ids;
+   BOOST_CHECK( ids.insert( object_id_type( 1, 2, 3 ) ) );
+   BOOST_CHECK( !ids.insert( object_id_type( 1, 2, 3 ) ) );
+   BOOST_CHECK_EQUAL( ids.count( object_id_type( 1, 2, 3 ) ), 1u );
+   ids.clear();
+   BOOST_CHECK( ids.empty() );
+   BOOST_CHECK( ids.find( object_id_type( 1, 2, 3 ) ) == ids.end() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( state_hash_test )
+{ try {
+   auto check_index_hashes = [this]() {
+      for( const auto& item : db.get_index_hashes() )
+         BOOST_CHECK( db.get_index( item.space, item.type ).scan_hash() == item.hash );
+   };
+
+   db.set_state_hash_tracking( true );
+   ACTORS((alice)(bob));
+   generate_block();
+   check_index_hashes();
+   const auto before = db.get_state_hash();
+   const uint32_t block_num = db.head_block_num();
+   {
+      auto session = db._undo_db.start_undo_session();
+      db.modify( alice_id(db), []( account_object& a ) { a.name = "alice2"; } );
+      db.remove( bob_id(db) );
+      db.create<account_object>( []( account_object& a ) { a.name = "carol"; } );
+      check_index_hashes();
+      BOOST_CHECK( db.get_state_hash() != before );
+   }
+   // undoing restores the objects, and with them the hashes
+   check_index_hashes();
+   BOOST_CHECK( db.get_state_hash() == before );
+
+   generate_block();
+   const auto hashes = db.get_state_hashes( block_num );
+   BOOST_REQUIRE( hashes.valid() );
+   BOOST_CHECK( hashes->block_id == db.get_block_id_for_num( block_num ) );
+   BOOST_CHECK( hashes->state_hash == before );
+   BOOST_CHECK( db.object_database::get_state_hash( hashes->indices ) == before );
+   BOOST_REQUIRE( db.get_state_hashes( db.head_block_num() ).valid() );
+   BOOST_CHECK( db.get_state_hashes( db.head_block_num() )->state_hash == db.get_state_hash() );
+
+   // a popped block's hashes are gone
+   const uint32_t head_num = db.head_block_num();
+   db.pop_block();
+   BOOST_CHECK( !db.get_state_hashes( head_num ).valid() );
+   BOOST_CHECK( db.get_state_hash() == before );
+
+   // without tracking the hashes are scanned for, and come out the same
+   db.set_state_hash_tracking( false );
+   db.modify( alice_id(db), []( account_object& a ) { a.name = "alice3"; } );
+   const auto untracked = db.get_state_hash();
+   BOOST_CHECK( untracked != before );
+   db.set_state_hash_tracking( true );
+   check_index_hashes();
+   BOOST_CHECK( db.get_state_hash() == untracked );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( dense_index_test )
+{ try {
+   ACTORS((alice)(bob));
+   const auto& accounts = db.get_index_type<account_index>();
+   BOOST_CHECK( accounts.find( alice_id ) == &alice_id(db) );
+   BOOST_CHECK( accounts.find( bob_id ) == &*accounts.indices().get<by_name>().find( "bob" ) );
+   // an id of another type with the same instance
+   BOOST_CHECK( accounts.find( asset_id_type( alice_id.instance ) ) == nullptr );
+   BOOST_CHECK( accounts.find( account_id_type( accounts.get_next_id().instance() + 10 ) ) == nullptr );
+
+   {
+      auto session = db._undo_db.start_undo_session();
+      db.remove( bob_id(db) );
+      BOOST_CHECK( db.find( bob_id ) == nullptr );
+   }
+   // undo inserts bob again, under the same id
+   BOOST_REQUIRE( db.find( bob_id ) != nullptr );
+   BOOST_CHECK_EQUAL( bob_id(db).name, "bob" );
+   BOOST_CHECK( accounts.find( bob_id ) == &*accounts.indices().get<by_id>().find( bob_id ) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( node_pool_test )
+{ try {
+   typedef multi_index_with_allocator< limit_order_multi_index_type,
+                                       node_pool_allocator<limit_order_object> >::type pooled_type;
+   node_pool pool;
+   pooled_type orders( pooled_type::ctor_args_list(), node_pool_allocator<limit_order_object>( &pool ) );
+   const auto insert_orders = [&orders]( uint64_t first, uint64_t count ) {
+      for( uint64_t i = first; i < first + count; ++i )
+      {
+         limit_order_object o;
+         o.id = limit_order_id_type( i );
+         orders.insert( std::move( o ) );
+      }
+   };
+
+   const uint64_t empty_nodes = pool.stats().nodes_in_use;
+   insert_orders( 0, 1000 );
+   BOOST_CHECK_EQUAL( pool.stats().nodes_in_use, empty_nodes + 1000 );
+   const auto slabs = pool.stats().slab_allocations;
+
+   // freed nodes are reused before any new slab is taken
+   orders.clear();
+   BOOST_CHECK_EQUAL( pool.stats().nodes_in_use, empty_nodes );
+   insert_orders( 1000, 1000 );
+   BOOST_CHECK_EQUAL( pool.stats().slab_allocations, slabs );
+   BOOST_CHECK_EQUAL( pool.stats().node_allocations, empty_nodes + 2000 );
+
+   // the chain's pooled indices report their pools
+   ACTOR(alice);
+   const auto pools = db.get_pool_stats();
+   const auto key = std::make_pair( uint32_t(implementation_ids), uint32_t(impl_transaction_object_type) );
+   BOOST_REQUIRE( pools.count( key ) );
+   BOOST_CHECK( pools.at( key ).nodes_in_use >= db.get_index_type<transaction_index>().indices().size() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( read_view_test )
+{ try {
+   ACTORS((alice)(bob));
+   const auto view = db.open_read_view();
+
+   db.modify( alice_id(db), []( account_object& a ) { a.name = "alice2"; } );
+   db.modify( alice_id(db), []( account_object& a ) { a.name = "alice3"; } );
+   db.remove( bob_id(db) );
+   ACTOR(carol);
+
+   // the view still shows the state it was opened on, also to other threads
+   const auto names = std::async( std::launch::async, [&view]() {
+      std::set<string> result;
+      for( const auto& a : view->get_all<account_object>() )
+         result.insert( a.name );
+      return result;
+   }).get();
+   BOOST_CHECK( names.count( "alice" ) && names.count( "bob" ) );
+   BOOST_CHECK( !names.count( "alice3" ) && !names.count( "carol" ) );
+   BOOST_CHECK_EQUAL( view->get( alice_id ).name, "alice" );
+   BOOST_CHECK( view->find( bob_id ).valid() );
+   BOOST_CHECK( !view->find( carol_id ).valid() );
+
+   // range reads find changed and removed objects by their keys as of the view, in index order
+   const auto named = view->get_range<account_index, by_name>( string( "alice" ), string( "bob" ) );
+   BOOST_REQUIRE_EQUAL( named.size(), 2u );
+   BOOST_CHECK_EQUAL( named[0].name, "alice" );
+   BOOST_CHECK_EQUAL( named[1].name, "bob" );
+
+   const auto current = db.open_read_view();
+   BOOST_CHECK_EQUAL( current->get( alice_id ).name, "alice3" );
+   BOOST_CHECK( !current->find( bob_id ).valid() );
+   BOOST_CHECK( current->find( carol_id ).valid() );
+
+   // an object changed after its batch was read is returned once, as it was read
+   for( uint32_t i = 0; i < read_view::batch_size; ++i )
+      db.create<account_object>( [i]( account_object& a ) { a.name = "reader-" + fc::to_string( uint64_t( i ) ); } );
+   const auto alices = [alice_id]( const vector<account_object>& accounts ) {
+      vector<string> names;
+      for( const auto& a : accounts )
+         if( a.id == alice_id )
+            names.push_back( a.name );
+      return names;
+   };
+
+   read_view scan( db );
+   bool modified = false;
+   scan.set_batch_observer( [&]() {
+      if( !modified )
+         db.modify( alice_id(db), []( account_object& a ) { a.name = "alice4"; } );
+      modified = true;
+   });
+   const auto all = scan.get_all<account_object>();
+   BOOST_CHECK( modified );
+   BOOST_CHECK( alices( all ) == vector<string>{ "alice3" } );
+
+   read_view ranged( db );
+   modified = false;
+   ranged.set_batch_observer( [&]() {
+      if( !modified )
+         db.modify( alice_id(db), []( account_object& a ) { a.name = "alice5"; } );
+      modified = true;
+   });
+   const auto range = ranged.get_range<account_index, by_name>( string( "a" ), string( "z" ) );
+   BOOST_CHECK( modified );
+   BOOST_CHECK( alices( range ) == vector<string>{ "alice4" } );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()  // dascoin_tests::object_database_tests
+
+BOOST_AUTO_TEST_SUITE_END()  // dascoin_tests
@@ -593,6 +593,42 @@ BOOST_AUTO_TEST_CASE(get_queue_by_page_test)
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE(queue_rank_and_page_test)
+{ try {
+  VAULT_ACTORS((first)(second)(third))
+  const account_id_type accounts[] = { first_id, second_id, third_id };
+
+  for ( uint32_t i = 0; i < 60; ++i )
+    push_op(submit_reserve_cycles_to_queue_operation(get_cycle_issuer_id(), accounts[i % 3], 100 + i, 200, ""));
+  generate_block();
+
+  const auto queue = _dal.get_reward_queue();
+  BOOST_REQUIRE_EQUAL(queue.size(), 60);
+
+  // The position of a submission is its index in the whole queue:
+  for ( const auto& account : accounts )
+  {
+    auto result_vec = *_dal.get_queue_submissions_with_pos(account).result;
+    BOOST_CHECK_EQUAL(result_vec.size(), 20);
+    for ( const auto& sub : result_vec )
+    {
+      BOOST_REQUIRE_LT(sub.position, queue.size());
+      BOOST_CHECK(queue[sub.position].id == sub.submission.id);
+    }
+  }
+
+  // Pages are slices of the whole queue:
+  for ( uint32_t from = 0; from < 60; from += 25 )
+  {
+    const uint32_t amount = std::min<uint32_t>(25, 60 - from);
+    const auto page = _dal.get_reward_queue_by_page(from, amount);
+    BOOST_REQUIRE_EQUAL(page.size(), amount);
+    for ( uint32_t i = 0; i < amount; ++i )
+      BOOST_CHECK(page[i].id == queue[from + i].id);
+  }
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,133 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018 Tech Solutions Malta LTD
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/exceptions.hpp>
+#include <graphene/chain/signature_cache.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+BOOST_FIXTURE_TEST_SUITE( dascoin_tests, database_fixture )
+
+BOOST_FIXTURE_TEST_SUITE( signature_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( precomputed_signature_keys )
+{ try {
+   const auto alice_key = generate_private_key( "alice" );
+   const auto bob_key = generate_private_key( "bob" );
+   const flat_set<public_key_type> alice_keys{ alice_key.get_public_key() };
+   const flat_set<public_key_type> bob_keys{ bob_key.get_public_key() };
+   const chain_id_type& chain_id = db.get_chain_id();
+
+   transfer_operation op;
+   op.from = account_id_type( 1 );
+   op.to = account_id_type( 2 );
+   op.amount = asset( 100 );
+   signed_transaction tx;
+   tx.operations.push_back( op );
+   tx.set_expiration( db.head_block_time() + 60 );
+   tx.sign( alice_key, chain_id );
+   tx.precompute_signature_keys( chain_id );
+   BOOST_REQUIRE( tx.get_precomputed_signature_keys( chain_id ).valid() );
+   BOOST_CHECK( tx.get_signature_keys( chain_id ) == alice_keys );
+
+   // new signatures or contents are recovered again
+   tx.signatures.clear();
+   tx.sign( bob_key, chain_id );
+   BOOST_CHECK( tx.get_signature_keys( chain_id ) == bob_keys );
+   tx.precompute_signature_keys( chain_id );
+   tx.set_expiration( db.head_block_time() + 120 );
+   BOOST_CHECK( !tx.get_precomputed_signature_keys( chain_id ).valid() );
+   BOOST_CHECK( tx.get_signature_keys( chain_id ) != bob_keys );
+
+   vector<signed_transaction> transactions( 16, tx );
+   vector<const signed_transaction*> pointers;
+   for( size_t i = 0; i < transactions.size(); ++i )
+   {
+      transactions[i].set_expiration( db.head_block_time() + 60 + i );
+      transactions[i].signatures.clear();
+      transactions[i].sign( alice_key, chain_id );
+      pointers.push_back( &transactions[i] );
+   }
+   // a duplicate signature does not stop the others from being precomputed
+   transactions[3].signatures.push_back( transactions[3].signatures.front() );
+   db.precompute_signature_keys( pointers );
+   for( size_t i = 0; i < transactions.size(); ++i )
+   {
+      if( i == 3 )
+         continue;
+      const auto keys = transactions[i].get_precomputed_signature_keys( chain_id );
+      BOOST_REQUIRE( keys.valid() );
+      BOOST_CHECK( *keys == alice_keys );
+   }
+   GRAPHENE_REQUIRE_THROW( transactions[3].get_signature_keys( chain_id ), tx_duplicate_sig );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( signature_cache_test )
+{ try {
+   auto& cache = signature_cache::instance();
+   cache.clear();
+   const auto alice_key = generate_private_key( "alice" );
+   const chain_id_type& chain_id = db.get_chain_id();
+
+   transfer_operation op;
+   op.from = account_id_type( 1 );
+   op.to = account_id_type( 2 );
+   op.amount = asset( 100 );
+   signed_transaction tx;
+   tx.operations.push_back( op );
+   tx.set_expiration( db.head_block_time() + 60 );
+   tx.sign( alice_key, chain_id );
+
+   // the same signature in another copy of the transaction is not recovered again
+   const signed_transaction copy = tx;
+   BOOST_CHECK( tx.get_signature_keys( chain_id ).count( alice_key.get_public_key() ) );
+   BOOST_CHECK( copy.get_signature_keys( chain_id ).count( alice_key.get_public_key() ) );
+   auto stats = cache.get_stats();
+   BOOST_CHECK_EQUAL( stats.misses, 1u );
+   BOOST_CHECK_EQUAL( stats.hits, 1u );
+   BOOST_CHECK_EQUAL( stats.entries, 1u );
+
+   cache.set_capacity( 4 );
+   for( uint32_t i = 0; i < 10; ++i )
+   {
+      tx.set_expiration( db.head_block_time() + 61 + i );
+      tx.signatures.clear();
+      tx.sign( alice_key, chain_id );
+      BOOST_CHECK( tx.get_signature_keys( chain_id ).count( alice_key.get_public_key() ) );
+   }
+   stats = cache.get_stats();
+   BOOST_CHECK_EQUAL( stats.misses, 11u );
+   BOOST_CHECK_LE( stats.entries, 4u );
+
+   cache.set_capacity( signature_cache::default_capacity );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()  // dascoin_tests::signature_tests
+
+BOOST_AUTO_TEST_SUITE_END()  // dascoin_tests